@@ -0,0 +1,639 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../libc/cstring.h"
+#include "../libc/hash_table.h"
+#include "../libc/logger.h"
+#include "../src/calculate.h"
+#include "../src/expression_tree.h"
+#include "../src/output.h"
+#include "../src/parser.h"
+#include "../src/postfix_notation.h"
+#include "../src/table.h"
+#include "generator.h"
+
+/*
+ * Benchmark driver. Generates formulas with a seeded generator, runs every
+ * processing stage over all of them separately and prints one JSON object
+ * with the best time of each stage over --repeat runs:
+ *
+ *     conversion  tokenizing and parsing into postfix (plus validation for
+ *                 tables), without tree
+ *     evaluation  binding variables and evaluating postfix; for tables one
+ *                 depth pre-pass per line and every row on a shared stack,
+ *                 the way table_create_table_of_truth does it
+ *     tree_build  conversion again, with expression trees built by the
+ *                 parser on the way, null for tables
+ *     rebind      changing every variable of a line in turn and taking the
+ *                 result again through expression_tree_cache, null for
+ *                 tables
+ *     output      writing human sections of already computed lines to
+ *                 /dev/null (truth table writing minus evaluation for tables)
+ *     end_to_end  process_*_line for every line, human format, to /dev/null
+ *
+ * --dump prints generated formulas instead, so they can be fed to the CLI.
+ */
+
+typedef struct {
+    generator_options generator;
+    size_t repeat;
+    int dump;
+} bench_options;
+
+typedef struct {
+    uint64_t conversion;
+    uint64_t evaluation;
+    uint64_t tree_build;
+    uint64_t rebind;
+    uint64_t output;
+    uint64_t end_to_end;
+} bench_stages;
+
+typedef struct {
+    char **lines;
+    size_t lines_count;
+    hash_table *operators;
+    hash_table *operands;  // every generated variable, calculate mode only
+    token_list **tokens;
+    expression_tree **trees;
+    int *results;
+    FILE *null_out;
+    size_t tokens_count;
+} bench_state;
+
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t bench_elapsed(uint64_t from, uint64_t to) {
+    return to > from ? to - from : 0;
+}
+
+static err_t bench_parse_size(const char *value, size_t *result) {
+    char *end = NULL;
+    unsigned long long parsed = strtoull(value, &end, 10);
+
+    if (*value == '\0' || *end != '\0') {
+        fprintf(stderr, "invalid number %s\n", value);
+        return INVALID_CLI_ARGUMENT;
+    }
+    *result = (size_t)parsed;
+    return EXIT_SUCCESS;
+}
+
+static err_t bench_parse_options(bench_options *options, int argc,
+                                 char *argv[]) {
+    int i = 0, operators_set = 0, depth_set = 0, lines_set = 0;
+    size_t value = 0;
+    err_t err = 0;
+
+    options->generator.mode = generate_calculate;
+    options->generator.seed = 1;
+    options->generator.variables_count = 4;
+    options->repeat = 3;
+    options->dump = 0;
+
+    for (i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--dump") == 0) {
+            options->dump = 1;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "unknown or incomplete option %s\n", argv[i]);
+            return INVALID_CLI_ARGUMENT;
+        }
+        if (strcmp(argv[i], "--mode") == 0) {
+            i++;
+            if (strcmp(argv[i], "calculate") == 0) {
+                options->generator.mode = generate_calculate;
+            } else if (strcmp(argv[i], "table") == 0) {
+                options->generator.mode = generate_table;
+            } else {
+                fprintf(stderr, "unknown mode %s\n", argv[i]);
+                return INVALID_CLI_ARGUMENT;
+            }
+            continue;
+        }
+        if (strcmp(argv[i], "--operators") == 0) {
+            options->generator.operators = argv[++i];
+            operators_set = 1;
+            continue;
+        }
+
+        err = bench_parse_size(argv[i + 1], &value);
+        if (err) {
+            return err;
+        }
+        if (strcmp(argv[i], "--seed") == 0) {
+            options->generator.seed = value;
+        } else if (strcmp(argv[i], "--depth") == 0) {
+            options->generator.depth = value;
+            depth_set = 1;
+        } else if (strcmp(argv[i], "--variables") == 0) {
+            options->generator.variables_count = value;
+        } else if (strcmp(argv[i], "--lines") == 0) {
+            options->generator.lines_count = value;
+            lines_set = 1;
+        } else if (strcmp(argv[i], "--repeat") == 0) {
+            options->repeat = value == 0 ? 1 : value;
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return INVALID_CLI_ARGUMENT;
+        }
+        i++;
+    }
+
+    // tables are exponential in variables, so they get smaller defaults
+    if (options->generator.mode == generate_calculate) {
+        if (!operators_set) {
+            options->generator.operators = "+,-,*,/,%,~";
+        }
+        if (!depth_set) {
+            options->generator.depth = 6;
+        }
+        if (!lines_set) {
+            options->generator.lines_count = 10000;
+        }
+    } else {
+        if (!operators_set) {
+            options->generator.operators = "&,|,~,->,+>,<>,=,!,?";
+        }
+        if (!depth_set) {
+            options->generator.depth = 4;
+        }
+        if (!lines_set) {
+            options->generator.lines_count = 1000;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static void bench_state_free(bench_state *state) {
+    size_t i = 0;
+
+    for (i = 0; i < state->lines_count; ++i) {
+        free(state->lines[i]);
+        if (state->tokens != NULL) {
+            token_list_free(state->tokens[i]);
+        }
+        if (state->trees != NULL) {
+            expression_tree_free(state->trees[i]);
+        }
+    }
+    free(state->lines);
+    free(state->tokens);
+    free(state->trees);
+    free(state->results);
+    hash_table_free(state->operators);
+    hash_table_free(state->operands);
+    if (state->null_out != NULL) {
+        fclose(state->null_out);
+    }
+}
+
+static err_t bench_generate(bench_state *state, const bench_options *options) {
+    generator *g = NULL;
+    String line = NULL;
+    size_t i = 0, count = options->generator.lines_count;
+    err_t err = 0;
+
+    state->lines = (char **)calloc(count, sizeof(char *));
+    state->tokens = (token_list **)calloc(count, sizeof(token_list *));
+    state->trees = (expression_tree **)calloc(count, sizeof(expression_tree *));
+    state->results = (int *)calloc(count, sizeof(int));
+    line = string_init();
+    if (state->lines == NULL || state->tokens == NULL ||
+        state->trees == NULL || state->results == NULL || line == NULL) {
+        string_free(line);
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    err = generator_init(&g, &options->generator);
+    if (err) {
+        string_free(line);
+        return err;
+    }
+
+    for (i = 0; i < count; ++i) {
+        err = generator_next(g, &line);
+        if (err) {
+            break;
+        }
+        // String isn't null terminated, lines are fed as C strings
+        state->lines[i] = (char *)malloc(string_len(line) + 1);
+        if (state->lines[i] == NULL) {
+            err = MEMORY_ALLOCATION_ERROR;
+            break;
+        }
+        memcpy(state->lines[i], line, string_len(line));
+        state->lines[i][string_len(line)] = '\0';
+        state->lines_count++;
+    }
+
+    generator_free(g);
+    string_free(line);
+    return err;
+}
+
+static err_t bench_fill_operands(bench_state *state, size_t variables_count) {
+    String name = NULL;
+    size_t i = 0, id = 0;
+    int value = 0;
+    err_t err = 0;
+
+    name = string_init();
+    if (name == NULL) {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    for (i = 0; i < variables_count; ++i) {
+        err = generator_variable_name(i, &name);
+        if (err) {
+            break;
+        }
+        err = string_pool_intern(string_pool_global(), name, string_len(name),
+                                 &id);
+        if (err) {
+            break;
+        }
+        value = (int)i + 2;
+        err = hash_table_set(state->operands, &id, &value);
+        if (err) {
+            break;
+        }
+    }
+    string_free(name);
+
+    return err;
+}
+
+static err_t bench_tokenize(const bench_state *state, const char *line,
+                            token_list **tokens) {
+    if (state->operands != NULL) {
+        return calculate_tokenize(line, state->operators, NULL, tokens);
+    }
+    return table_tokenize(line, state->operators, NULL, tokens);
+}
+
+static err_t bench_conversion(bench_state *state, uint64_t *elapsed) {
+    size_t i = 0;
+    uint64_t start = 0;
+    err_t err = 0;
+
+    for (i = 0; i < state->lines_count; ++i) {
+        token_list_free(state->tokens[i]);
+        state->tokens[i] = NULL;
+    }
+
+    state->tokens_count = 0;
+    start = bench_now_ns();
+    for (i = 0; i < state->lines_count; ++i) {
+        err = bench_tokenize(state, state->lines[i], &state->tokens[i]);
+        if (err) {
+            return err;
+        }
+        err = parse_tokens(state->tokens[i], NULL);
+        if (!err && state->operands == NULL) {
+            err = table_validate_postfix(state->tokens[i]);
+        }
+        if (err) {
+            return err;
+        }
+        state->tokens_count += state->tokens[i]->size;
+    }
+    *elapsed = bench_elapsed(start, bench_now_ns());
+
+    return EXIT_SUCCESS;
+}
+
+static err_t bench_evaluation(bench_state *state, uint64_t *elapsed) {
+    size_t i = 0, row = 0, j = 0, symbols_count = 0, depth = 0;
+    int values[64];
+    int_vector stack;
+    uint64_t start = 0;
+    err_t err = 0;
+
+    start = bench_now_ns();
+    for (i = 0; i < state->lines_count; ++i) {
+        symbols_count = state->tokens[i]->symbols_count;
+        if (symbols_count >= sizeof(values) / sizeof(values[0])) {
+            return INDEX_OUT_OF_BOUNDS;
+        }
+        if (state->operands != NULL) {
+            err = calculate_bind_variables(state->tokens[i], state->operands,
+                                           NULL, NULL, values);
+            if (!err) {
+                err = calculate_postfix_expression(state->tokens[i], values,
+                                                   NULL, &state->results[i]);
+            }
+            if (err) {
+                return err;
+            }
+            continue;
+        }
+        err = postfix_stack_depth(state->tokens[i], &depth);
+        if (!err) {
+            err = int_vector_init(&stack, depth, NULL);
+        }
+        if (err) {
+            return err;
+        }
+        for (row = 0; row < ((size_t)1 << symbols_count); ++row) {
+            for (j = 0; j < symbols_count; ++j) {
+                values[j] = (row & ((size_t)1 << j)) != 0;
+            }
+            state->results[i] =
+                postfix_evaluate(state->tokens[i], values, &stack);
+        }
+        int_vector_free(&stack);
+    }
+    *elapsed = bench_elapsed(start, bench_now_ns());
+
+    return EXIT_SUCCESS;
+}
+
+// trees come from the parser, so they cost tree_build minus conversion
+static err_t bench_tree_build(bench_state *state, uint64_t *elapsed) {
+    size_t i = 0;
+    uint64_t start = 0;
+    err_t err = 0;
+
+    for (i = 0; i < state->lines_count; ++i) {
+        expression_tree_free(state->trees[i]);
+        state->trees[i] = NULL;
+        token_list_free(state->tokens[i]);
+        state->tokens[i] = NULL;
+    }
+
+    start = bench_now_ns();
+    for (i = 0; i < state->lines_count; ++i) {
+        err = bench_tokenize(state, state->lines[i], &state->tokens[i]);
+        if (!err) {
+            err = parse_tokens(state->tokens[i], &state->trees[i]);
+        }
+        if (err) {
+            return err;
+        }
+    }
+    *elapsed = bench_elapsed(start, bench_now_ns());
+
+    return EXIT_SUCCESS;
+}
+
+// only rebinding is timed, caches are set up from bound values beforehand
+static err_t bench_rebind(bench_state *state, uint64_t *elapsed) {
+    memory_arena *arena = NULL;
+    expression_tree_cache *cache = NULL;
+    size_t i = 0, j = 0, symbols_count = 0;
+    int values[64];
+    uint64_t start = 0;
+    err_t err = 0;
+
+    err = memory_arena_init(&arena, MEMORY_ARENA_BLOCK_SIZE);
+    if (err) {
+        return err;
+    }
+
+    *elapsed = 0;
+    for (i = 0; i < state->lines_count; ++i) {
+        symbols_count = state->tokens[i]->symbols_count;
+        if (symbols_count >= sizeof(values) / sizeof(values[0])) {
+            err = INDEX_OUT_OF_BOUNDS;
+            break;
+        }
+        err = calculate_bind_variables(state->tokens[i], state->operands,
+                                       NULL, NULL, values);
+        if (!err) {
+            err = expression_tree_cache_init(&cache, state->trees[i], values,
+                                             arena);
+        }
+        if (err) {
+            break;
+        }
+
+        start = bench_now_ns();
+        for (j = 0; j < symbols_count; ++j) {
+            expression_tree_cache_set(cache, j, values[j] + 1);
+            expression_tree_cache_result(cache);
+        }
+        *elapsed += bench_elapsed(start, bench_now_ns());
+        memory_arena_reset(arena);
+    }
+
+    memory_arena_free(arena);
+    return err;
+}
+
+static err_t bench_output(bench_state *state, uint64_t evaluation,
+                          uint64_t *elapsed) {
+    FILE *out = state->null_out;
+    size_t i = 0;
+    uint64_t start = 0;
+    err_t err = 0;
+
+    start = bench_now_ns();
+    for (i = 0; i < state->lines_count; ++i) {
+        fprintf(out, "Source: (inf) %s", state->lines[i]);
+        fprintf(out, "\nConverted: (post) ");
+        token_list_fprint(out, state->tokens[i]);
+        fprintf(out, "\n\n");
+        if (state->operands == NULL) {
+            err = table_create_table_of_truth(state->tokens[i], out,
+                                              format_human, NULL);
+            if (err) {
+                return err;
+            }
+            continue;
+        }
+        fputs("Expression evalutation result: ", out);
+        output_int(out, state->results[i]);
+        putc('\n', out);
+        err = expression_tree_fprint(out, state->trees[i]);
+        if (err) {
+            return err;
+        }
+    }
+    fflush(out);
+    *elapsed = bench_elapsed(start, bench_now_ns());
+    if (state->operands == NULL) {
+        *elapsed = bench_elapsed(evaluation, *elapsed);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// lines are processed the way process_*_file does, through a line arena
+static err_t bench_end_to_end(bench_state *state, uint64_t *elapsed) {
+    output_context context = {&output_default_options, "bench", 0};
+    memory_arena *arena = NULL;
+    size_t i = 0;
+    uint64_t start = 0;
+    err_t err = 0;
+
+    err = memory_arena_init(&arena, MEMORY_ARENA_BLOCK_SIZE);
+    if (err) {
+        return err;
+    }
+
+    start = bench_now_ns();
+    for (i = 0; i < state->lines_count; ++i) {
+        context.line = i;
+        if (state->operands != NULL) {
+            err = process_calculate_line(state->lines[i], state->operators,
+                                         state->operands, state->null_out,
+                                         NULL, &context, arena);
+        } else {
+            err = process_table_line(state->lines[i], state->operators,
+                                     state->null_out, &context, arena);
+        }
+        memory_arena_reset(arena);
+        if (err) {
+            memory_arena_free(arena);
+            return err;
+        }
+    }
+    fflush(state->null_out);
+    *elapsed = bench_elapsed(start, bench_now_ns());
+    memory_arena_free(arena);
+
+    return EXIT_SUCCESS;
+}
+
+static void bench_keep_min(uint64_t *best, uint64_t value, size_t run) {
+    if (run == 0 || value < *best) {
+        *best = value;
+    }
+}
+
+static err_t bench_run(bench_state *state, const bench_options *options,
+                       bench_stages *best) {
+    bench_stages stages = {0, 0, 0, 0, 0, 0};
+    size_t run = 0;
+    err_t err = 0;
+
+    for (run = 0; run < options->repeat; ++run) {
+        err = bench_conversion(state, &stages.conversion);
+        if (!err) {
+            err = bench_evaluation(state, &stages.evaluation);
+        }
+        if (!err && state->operands != NULL) {
+            err = bench_tree_build(state, &stages.tree_build);
+        }
+        if (!err && state->operands != NULL) {
+            err = bench_rebind(state, &stages.rebind);
+        }
+        if (!err) {
+            err = bench_output(state, stages.evaluation, &stages.output);
+        }
+        if (!err) {
+            err = bench_end_to_end(state, &stages.end_to_end);
+        }
+        if (err) {
+            return err;
+        }
+
+        bench_keep_min(&best->conversion, stages.conversion, run);
+        bench_keep_min(&best->evaluation, stages.evaluation, run);
+        bench_keep_min(&best->tree_build, stages.tree_build, run);
+        bench_keep_min(&best->rebind, stages.rebind, run);
+        bench_keep_min(&best->output, stages.output, run);
+        bench_keep_min(&best->end_to_end, stages.end_to_end, run);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static void bench_print(const bench_state *state, const bench_options *options,
+                        const bench_stages *best) {
+    const generator_options *g = &options->generator;
+    int is_calculate = g->mode == generate_calculate;
+
+    printf("{\"mode\":\"%s\",\"seed\":%llu,\"depth\":%zu,\"variables\":%zu,",
+           is_calculate ? "calculate" : "table", (unsigned long long)g->seed,
+           g->depth, g->variables_count);
+    printf("\"operators\":\"");
+    output_escaped(stdout, format_jsonl, g->operators, strlen(g->operators));
+    printf("\",\"lines\":%zu,\"tokens\":%zu,\"repeat\":%zu,",
+           state->lines_count, state->tokens_count, options->repeat);
+    printf("\"stages_ns\":{\"conversion\":%llu,\"evaluation\":%llu,",
+           (unsigned long long)best->conversion,
+           (unsigned long long)best->evaluation);
+    if (is_calculate) {
+        printf("\"tree_build\":%llu,\"rebind\":%llu,",
+               (unsigned long long)best->tree_build,
+               (unsigned long long)best->rebind);
+    } else {
+        printf("\"tree_build\":null,\"rebind\":null,");
+    }
+    printf("\"output\":%llu,\"end_to_end\":%llu}}\n",
+           (unsigned long long)best->output,
+           (unsigned long long)best->end_to_end);
+}
+
+int main(int argc, char *argv[]) {
+    bench_options options;
+    bench_state state;
+    bench_stages best;
+    size_t i = 0;
+    err_t err = 0;
+
+    memset(&options, 0, sizeof(options));
+    memset(&state, 0, sizeof(state));
+    memset(&best, 0, sizeof(best));
+
+    // no logger is started: division by zero and alike stay quiet
+    err = bench_parse_options(&options, argc, argv);
+    if (err) {
+        return err;
+    }
+
+    err = bench_generate(&state, &options);
+    if (err) {
+        fprintf(stderr, "failed to generate formulas, error %d\n", err);
+        bench_state_free(&state);
+        return err;
+    }
+    if (options.dump) {
+        for (i = 0; i < state.lines_count; ++i) {
+            printf("%s\n", state.lines[i]);
+        }
+        bench_state_free(&state);
+        return EXIT_SUCCESS;
+    }
+
+    if (options.generator.mode == generate_calculate) {
+        err = calculate_init_hash_tables(&state.operators, &state.operands);
+        if (!err) {
+            err = bench_fill_operands(&state,
+                                      options.generator.variables_count);
+        }
+    } else {
+        err = table_init_hash_table(&state.operators);
+    }
+    if (!err) {
+        state.null_out = fopen("/dev/null", "w");
+        if (state.null_out == NULL) {
+            err = OPENING_THE_FILE_ERROR;
+        }
+    }
+    if (!err) {
+        err = bench_run(&state, &options, &best);
+    }
+    if (err) {
+        fprintf(stderr, "benchmark failed, error %d\n", err);
+        bench_state_free(&state);
+        return err;
+    }
+
+    bench_print(&state, &options, &best);
+
+    bench_state_free(&state);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,202 @@
+#include "generator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../libc/logger.h"
+
+// xorshift64*, rand() differs between libcs
+static uint64_t generator_random(generator *g) {
+    g->state ^= g->state >> 12;
+    g->state ^= g->state << 25;
+    g->state ^= g->state >> 27;
+    return g->state * 0x2545F4914F6CDD1DULL;
+}
+
+static size_t generator_below(generator *g, size_t bound) {
+    return (size_t)(generator_random(g) % bound);
+}
+
+void generator_free(generator *g) {
+    size_t i = 0;
+
+    if (g == NULL) {
+        return;
+    }
+    for (i = 0; i < g->operators_count; ++i) {
+        string_free(g->operators[i]);
+    }
+    free(g->operators);
+    free(g);
+}
+
+err_t generator_init(generator **g, const generator_options *options) {
+    if (g == NULL || options == NULL || options->operators == NULL) {
+        log_error("passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    generator *gen = NULL;
+    const char *op = options->operators;
+    size_t length = 0, count = 1, i = 0;
+
+    for (i = 0; op[i] != '\0'; ++i) {
+        if (op[i] == ',') {
+            count++;
+        }
+    }
+
+    gen = (generator *)calloc(1, sizeof(generator));
+    if (gen == NULL) {
+        log_error("failed to allocate memory for generator");
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    gen->options = *options;
+    gen->state = options->seed == 0 ? 1 : options->seed;  // 0 is a fixpoint
+    gen->operators = (String *)calloc(count, sizeof(String));
+    if (gen->operators == NULL) {
+        log_error("failed to allocate memory for operators");
+        free(gen);
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    while (1) {
+        length = strcspn(op, ",");
+        if (length > 0) {
+            gen->operators[gen->operators_count] =
+                string_from_slice(op, length);
+            if (gen->operators[gen->operators_count] == NULL) {
+                log_error("failed to allocate memory for operator");
+                generator_free(gen);
+                return MEMORY_ALLOCATION_ERROR;
+            }
+            gen->operators_count++;
+        }
+        if (op[length] == '\0') {
+            break;
+        }
+        op += length + 1;
+    }
+    if (gen->operators_count == 0) {
+        log_error("no operators to generate formulas from");
+        generator_free(gen);
+        return INVALID_INPUT_DATA;
+    }
+
+    *g = gen;
+    return EXIT_SUCCESS;
+}
+
+err_t generator_variable_name(size_t i, String *name) {
+    char reversed[32];
+    size_t length = 0;
+    err_t err = 0;
+
+    string_clear(*name);
+    do {
+        reversed[length++] = 'a' + i % 26;
+        i /= 26;
+    } while (i > 0);
+    while (length > 0) {
+        err = string_add(name, reversed[--length]);
+        if (err) {
+            return err;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static err_t generator_leaf(generator *g, String *line, String *scratch) {
+    char number[8];
+    err_t err = 0;
+
+    if (g->options.variables_count > 0 && generator_below(g, 2) == 0) {
+        err = generator_variable_name(
+            generator_below(g, g->options.variables_count), scratch);
+        if (err) {
+            return err;
+        }
+        return string_cat(line, scratch);
+    }
+
+    if (g->options.mode == generate_table) {
+        sprintf(number, "%d", (int)generator_below(g, 2));
+    } else {
+        sprintf(number, "%d", (int)generator_below(g, 99) + 1);
+    }
+    return string_cat_c(line, number);
+}
+
+static err_t generator_expression(generator *g, String *line, String *scratch,
+                                  size_t depth, int is_root) {
+    const String op = g->operators[generator_below(g, g->operators_count)];
+    int braces = 0;
+    err_t err = 0;
+
+    // leaves appear above max depth too, so lines differ in shape
+    if (depth == 0 || (!is_root && generator_below(g, 4) == 0)) {
+        return generator_leaf(g, line, scratch);
+    }
+
+    if (string_cmp_c(op, "~") == 0) {
+        err = string_cat_c(line, "~(");
+        if (!err) {
+            err = generator_expression(g, line, scratch, depth - 1, 0);
+        }
+        if (!err) {
+            err = string_add(line, ')');
+        }
+        return err;
+    }
+
+    braces = !is_root && generator_below(g, 4) != 0;
+    if (braces) {
+        err = string_add(line, '(');
+    }
+    if (!err) {
+        err = generator_expression(g, line, scratch, depth - 1, 0);
+    }
+    if (!err) {
+        err = string_add(line, ' ');
+    }
+    if (!err) {
+        err = string_cat(line, &op);
+    }
+    if (!err) {
+        err = string_add(line, ' ');
+    }
+    if (!err) {
+        err = generator_expression(g, line, scratch, depth - 1, 0);
+    }
+    if (!err && braces) {
+        err = string_add(line, ')');
+    }
+    return err;
+}
+
+err_t generator_next(generator *g, String *line) {
+    if (g == NULL || line == NULL) {
+        log_error("passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    String scratch = NULL;
+    err_t err = 0;
+
+    scratch = string_init();
+    if (scratch == NULL) {
+        log_error("failed to allocate memory for string");
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    string_clear(*line);
+    err = generator_expression(g, line, &scratch, g->options.depth, 1);
+    string_free(scratch);
+    if (err) {
+        log_error("failed to generate formula");
+        return err;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,42 @@
+#ifndef GENERATOR_H_
+#define GENERATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../libc/cstring.h"
+#include "../libc/errors.h"
+
+typedef enum { generate_calculate, generate_table } generator_mode;
+
+typedef struct {
+    generator_mode mode;
+    uint64_t seed;
+    size_t depth;            // max depth of operators nesting
+    size_t variables_count;  // distinct variable names in use
+    const char *operators;   // comma separated operators to pick from
+    size_t lines_count;
+} generator_options;
+
+/*
+ * Deterministic formula generator: the same options always give the same
+ * lines, no matter the platform. Literals are 0 and 1 for table mode and
+ * 1..99 for calculate mode, unary operators ("~") are applied prefix.
+ */
+typedef struct {
+    generator_options options;
+    uint64_t state;
+    String *operators;  // parsed options.operators
+    size_t operators_count;
+} generator;
+
+err_t generator_init(generator **g, const generator_options *options);
+void generator_free(generator *g);
+
+// replaces content of line with next formula
+err_t generator_next(generator *g, String *line);
+
+// name of i-th variable: a, b, ..., z, ba, bb, ...
+err_t generator_variable_name(size_t i, String *name);
+
+#endif  // !GENERATOR_H_
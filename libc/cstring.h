@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "memory.h"
+
 #define STRING_GROWTH_FACTOR (2)
 #define STRING_BASE_CAPACITY (16)
 
@@ -12,6 +14,7 @@ typedef char *String;
 typedef struct {
     size_t length;
     size_t capacity;
+    size_t hash;  // cached string_hash, 0 until computed
 } String_metadata_t;
 
 #define __cstring_string_to_base(str) (&((String_metadata_t *)(str))[-1])
@@ -21,9 +24,17 @@ typedef struct {
 #define string_cap(str) (str ? __cstring_string_to_base(str)->capacity : 0)
 
 String string_init();
+// empty string with room for capacity bytes, no regrowth below that
+String string_init_with_capacity(size_t capacity);
 String string_from(const char *str);
+String string_from_slice(const char *bytes, size_t length);
+// string in arena memory with capacity equal to length: it may be changed
+// only within that capacity and never freed
+String string_arena_copy(memory_arena *arena, const char *bytes,
+                         size_t length);
 
 void string_free(const String str);
+void string_clear(String str);
 
 int string_add(String *str, char c);
 
@@ -44,6 +55,46 @@ int string_c_str(const char *haystack, const String needle);
 
 int string_grow(String *str, size_t new_size);
 
+/*
+ * Builder functions. string_reserve makes room for capacity bytes growing
+ * geometrically, so appending one slice at a time stays linear, and
+ * string_shrink_to_fit gives back what is left once the string is built.
+ */
+int string_reserve(String *str, size_t capacity);
+int string_append(String *str, const char *bytes, size_t length);
+int string_shrink_to_fit(String *str);
+
 int string_add_str(String *str, const char *s);
 
+// wyhash of the content, cached until the string is changed by a string_*
+// function (writes through the char pointer must not follow a hash)
+size_t string_hash(const String str);
+
+/*
+ * Intern pool: every distinct byte sequence gets one canonical String and a
+ * dense id, so equal symbols compare by id (or by pointer). Canonical
+ * strings belong to the pool and must not be changed or freed.
+ */
+#define STRING_POOL_BASE_CAPACITY (64)
+
+typedef struct {
+    String *strings;  // canonical strings by id
+    size_t count;
+    size_t capacity;
+    size_t *index;  // open addressing over ids, SIZE_MAX marks a free slot
+    size_t index_capacity;
+} string_pool;
+
+int string_pool_init(string_pool **pool);
+void string_pool_free(string_pool *pool);
+// drops every string and makes all ids invalid, storage is kept for reuse
+void string_pool_clear(string_pool *pool);
+int string_pool_intern(string_pool *pool, const char *bytes, size_t length,
+                       size_t *id);
+String string_pool_string(const string_pool *pool, size_t id);
+
+// process wide pool, created on first use
+string_pool *string_pool_global();
+void string_pool_global_free();
+
 #endif
@@ -33,5 +33,10 @@ typedef int err_t;
 #define INVALID_SYMBOL (26)
 #define INVALID_OPERATIONS (27)
 #define INVALID_OPERAND (28)
+#define UNKNOWN_VARIABLE (29)
+#define LOGGER_THREAD_ERROR (30)
+#define NUMBER_OVERFLOW (31)
+#define WRITING_THE_FILE_ERROR (32)
+#define INVALID_BINDING (33)
 
 #endif
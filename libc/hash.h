@@ -0,0 +1,25 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HASH_DEFAULT_SEED (0x9e3779b97f4a7c15ULL)
+
+/*
+ * wyhash: reads 8 bytes at a time and folds them with 64x64->128 bit
+ * multiplications. Not cryptographic, only for hash tables.
+ */
+uint64_t wyhash(const void *data, size_t len, uint64_t seed);
+
+// murmur3 finalizer, spreads every input bit over the whole word
+static inline uint64_t hash_mix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+#endif
@@ -2,36 +2,82 @@
 #define HASH_TABLE_H_
 
 #include "cstring.h"
-#include "u_list.h"
+#include "errors.h"
 
-#define HASHSIZE (128)
+#define HASHSIZE (128)  // initial capacity, a power of two
+#define HASH_TABLE_GROUP_WIDTH (16)
 #define HASH_TABLE_GROWTH_FACTOR (2)
 #define HASH_TABLE_SHRINK_FACTOR (2)
+#define HASH_TABLE_MIGRATE_SLOTS (2 * HASH_TABLE_GROUP_WIDTH)
 
+// key and value of an entry, handed to bucket_destructor
 typedef struct hash_table_bucket {
     void *key;
     void *value;
 } hash_table_bucket;
 
+// control bytes and slots of one generation of the table
 typedef struct {
-    u_list **buckets;
-    size_t size;
+    unsigned char *control;
+    unsigned char *slots;
     size_t capacity;
+} hash_table_storage;
+
+/*
+ * Open addressing table in the Swiss table style: one control byte per slot
+ * (empty, deleted or 7 bits of the hash) probed a group of 16 at a time,
+ * full hash codes, keys and values stored inline in the slots.
+ * An incremental table keeps the previous storage after a resize and moves
+ * HASH_TABLE_MIGRATE_SLOTS of its slots on every set and dispose.
+ */
+typedef struct {
+    hash_table_storage current;
+    hash_table_storage previous;  // control is NULL when nothing migrates
+    size_t migrated;              // previous slots below it are moved
+    int incremental;
+    size_t size;
+    size_t growth_left;  // inserts into empty slots left before a resize
+    size_t initial_capacity;
     size_t key_size;
     size_t value_size;
-    size_t max_chain_length;
-    size_t min_chain_length;
+    size_t key_offset;
+    size_t value_offset;
+    size_t slot_size;
     int (*keys_comparer)(const void *, const void *);
     size_t (*hash)(const void *key, size_t key_size, size_t capacity);
     void (*bucket_destructor)(void *);
 } hash_table;
 
+/*
+ * Keys and values are copied into storage owned by the table.
+ * bucket_destructor (may be NULL) gets the hash_table_bucket of an entry
+ * that leaves the table and only disposes of what its key and value refer
+ * to, the table releases the storage itself.
+ * keys_comparer gets pointers to two keys and returns 0 when they are equal.
+ * hash is called with SIZE_MAX as capacity to get the whole hash code,
+ * NULL picks wyhash_hash.
+ * Value pointers from hash_table_get stay valid until the next set or
+ * dispose.
+ * Storage is allocated by the first insert, hash_table_init sizes it for
+ * HASHSIZE slots.
+ */
 err_t hash_table_init(
     hash_table **ht, int (*keys_comparer)(const void *, const void *),
     size_t (*hash)(const void *key, size_t key_size, size_t capacity),
     size_t key_size, size_t value_size, void (*bucket_destructor)(void *));
+// first allocation fits expected_size entries without a resize
+err_t hash_table_init_with_hint(
+    hash_table **ht, int (*keys_comparer)(const void *, const void *),
+    size_t (*hash)(const void *key, size_t key_size, size_t capacity),
+    size_t key_size, size_t value_size, void (*bucket_destructor)(void *),
+    size_t expected_size);
+
+// resizes move entries in steps instead of all at once (off by default)
+err_t hash_table_set_incremental(hash_table *ht, int enable);
 
 void hash_table_free(hash_table *ht);
+// disposes of every entry but keeps the storage for reuse
+err_t hash_table_clear(hash_table *ht);
 
 err_t hash_table_set(hash_table *ht, const void *key, const void *value);
 err_t hash_table_get(hash_table *ht, const void *key, void **value_placeholder);
@@ -45,6 +91,10 @@ err_t hash_table_get_chain_length_factor(
     hash_table *ht, double *chain_length_factor_placeholder);
 
 /* --------------- EXAMPLE FUNCTIONS --------------- */
+// String keys, the code is cached in the key, see string_hash()
+size_t wyhash_hash(const void *key, size_t key_size, size_t capacity);
+// size_t keys such as string_pool ids, the table mixes the code itself
+size_t id_hash(const void *key, size_t key_size, size_t capacity);
 size_t djb2_hash(const void *key, size_t key_size, size_t capacity);
 size_t murmur_hash(const void *key, size_t key_size, size_t capacity);
 size_t sha256_hash(const void *key, size_t key_size, size_t capacity);
@@ -0,0 +1,134 @@
+#ifndef HASHMAP_H_
+#define HASHMAP_H_
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "errors.h"
+#include "hash.h"
+#include "memory.h"
+
+#define HASHMAP_BASE_CAPACITY (16)
+
+// hash and equals for maps keyed by dense ids (string_pool ids and alike)
+static inline size_t hashmap_id_hash(size_t id) {
+    return (size_t)hash_mix64((uint64_t)id);
+}
+static inline int hashmap_id_equals(size_t a, size_t b) { return a == b; }
+
+/*
+ * DEFINE_HASHMAP(name, key_type, value_type, hash, equals) generates a
+ * linear probing map with keys and values stored inline and static inline
+ * functions name_init, name_free, name_get and name_set. hash(key) gives
+ * size_t and equals(a, b) non-zero for equal keys, both are called
+ * directly and may be inlined. The table is kept at most half full and
+ * entries are never removed. Storage comes from the heap or from an arena
+ * (then name_free does nothing).
+ */
+#define DEFINE_HASHMAP(name, key_type, value_type, hash, equals)               \
+    typedef struct {                                                           \
+        key_type key;                                                          \
+        value_type value;                                                      \
+    } name##_entry;                                                            \
+                                                                               \
+    typedef struct {                                                           \
+        name##_entry *entries;                                                 \
+        unsigned char *used; /* flag per entry, right after entries */         \
+        size_t size;                                                           \
+        size_t capacity; /* power of two */                                    \
+        memory_arena *arena; /* NULL for heap */                               \
+    } name;                                                                    \
+                                                                               \
+    static inline err_t name##_allocate(name *m, size_t capacity) {            \
+        size_t bytes = capacity * (sizeof(name##_entry) + 1);                  \
+        if (m->arena != NULL) {                                                \
+            m->entries = (name##_entry *)memory_arena_alloc(m->arena, bytes);  \
+        } else {                                                               \
+            m->entries = (name##_entry *)memory_alloc(MEM_OTHER, bytes);       \
+        }                                                                      \
+        if (m->entries == NULL) {                                              \
+            return MEMORY_ALLOCATION_ERROR;                                    \
+        }                                                                      \
+        m->used = (unsigned char *)(m->entries + capacity);                    \
+        memset(m->used, 0, capacity);                                          \
+        m->capacity = capacity;                                                \
+        return EXIT_SUCCESS;                                                   \
+    }                                                                          \
+                                                                               \
+    static inline err_t name##_init(name *m, size_t expected_size,             \
+                                    memory_arena *arena) {                     \
+        size_t capacity = HASHMAP_BASE_CAPACITY;                               \
+        if (m == NULL) {                                                       \
+            return DEREFERENCING_NULL_PTR;                                     \
+        }                                                                      \
+        while (capacity < expected_size * 2) {                                 \
+            capacity <<= 1;                                                    \
+        }                                                                      \
+        m->size = 0;                                                           \
+        m->arena = arena;                                                      \
+        return name##_allocate(m, capacity);                                   \
+    }                                                                          \
+                                                                               \
+    static inline void name##_free(name *m) {                                  \
+        if (m != NULL && m->arena == NULL) {                                   \
+            memory_free(m->entries);                                           \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    /* slot of key or the free slot where it would go */                       \
+    static inline size_t name##_slot(const name *m, key_type key) {            \
+        size_t mask = m->capacity - 1, slot = hash(key) & mask;                \
+        while (m->used[slot] && !equals(m->entries[slot].key, key)) {          \
+            slot = (slot + 1) & mask;                                          \
+        }                                                                      \
+        return slot;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline value_type *name##_get(const name *m, key_type key) {        \
+        size_t slot = name##_slot(m, key);                                     \
+        return m->used[slot] ? &m->entries[slot].value : NULL;                 \
+    }                                                                          \
+                                                                               \
+    static inline err_t name##_grow(name *m) {                                 \
+        name##_entry *entries = m->entries;                                    \
+        unsigned char *used = m->used;                                         \
+        size_t capacity = m->capacity, i = 0, slot = 0;                        \
+        err_t err = name##_allocate(m, capacity * 2);                          \
+        if (err) {                                                             \
+            m->entries = entries;                                              \
+            m->used = used;                                                    \
+            return err;                                                        \
+        }                                                                      \
+        for (i = 0; i < capacity; ++i) {                                       \
+            if (used[i]) {                                                     \
+                slot = name##_slot(m, entries[i].key);                         \
+                m->entries[slot] = entries[i];                                 \
+                m->used[slot] = 1;                                             \
+            }                                                                  \
+        }                                                                      \
+        if (m->arena == NULL) {                                                \
+            memory_free(entries);                                              \
+        }                                                                      \
+        return EXIT_SUCCESS;                                                   \
+    }                                                                          \
+                                                                               \
+    static inline err_t name##_set(name *m, key_type key, value_type value) {  \
+        size_t slot = name##_slot(m, key);                                     \
+        err_t err = 0;                                                         \
+        if (!m->used[slot]) {                                                  \
+            if ((m->size + 1) * 2 > m->capacity) {                             \
+                err = name##_grow(m);                                          \
+                if (err) {                                                     \
+                    return err;                                                \
+                }                                                              \
+                slot = name##_slot(m, key);                                    \
+            }                                                                  \
+            m->entries[slot].key = key;                                        \
+            m->used[slot] = 1;                                                 \
+            m->size++;                                                         \
+        }                                                                      \
+        m->entries[slot].value = value;                                        \
+        return EXIT_SUCCESS;                                                   \
+    }
+
+#endif
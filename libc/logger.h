@@ -17,17 +17,69 @@ typedef enum {
     LOG_FATAL
 } log_level;
 
+// calls below LOG_COMPILE_LEVEL (numbered as log_level) compile to nothing,
+// release builds pass -DLOG_COMPILE_LEVEL=3 to keep info and above
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 0
+#endif
+
+// arguments stay type checked but are never evaluated
+#define log_stripped(...)                                         \
+    do {                                                          \
+        if (0) {                                                  \
+            log_log(LOG_TRACE, __FILE__, __LINE__, __VA_ARGS__); \
+        }                                                         \
+    } while (0)
+
 #define log_io(...) log_log(LOG_IO, __FILE__, __LINE__, __VA_ARGS__)
+
+#if LOG_COMPILE_LEVEL > 1
+#define log_trace(...) log_stripped(__VA_ARGS__)
+#else
 #define log_trace(...) log_log(LOG_TRACE, __FILE__, __LINE__, __VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL > 2
+#define log_debug(...) log_stripped(__VA_ARGS__)
+#else
 #define log_debug(...) log_log(LOG_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL > 3
+#define log_info(...) log_stripped(__VA_ARGS__)
+#else
 #define log_info(...) log_log(LOG_INFO, __FILE__, __LINE__, __VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL > 4
+#define log_warn(...) log_stripped(__VA_ARGS__)
+#else
 #define log_warn(...) log_log(LOG_WARN, __FILE__, __LINE__, __VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL > 5
+#define log_error(...) log_stripped(__VA_ARGS__)
+#else
 #define log_error(...) log_log(LOG_ERROR, __FILE__, __LINE__, __VA_ARGS__)
+#endif
+
+#if LOG_COMPILE_LEVEL > 6
+#define log_fatal(...) log_stripped(__VA_ARGS__)
+#else
 #define log_fatal(...) log_log(LOG_FATAL, __FILE__, __LINE__, __VA_ARGS__)
+#endif
 
+#define LOG_ASYNC_CAPACITY (1024)
+// longer messages are truncated in async mode
+#define LOG_RECORD_TEXT_SIZE (512)
+
+// settings and logging may be used from any thread, also while others log;
+// a line written by one thread is never interleaved with another one
 void log_set_user_interaction(int enable);
 void log_set_level(log_level level);
 err_t log_add_fp(FILE *fp, log_level level);
+// moves every logger that writes to from over to to
+err_t log_replace_fp(FILE *from, FILE *to);
 
 void log_log(log_level level, const char *file, int line, const char *fmt, ...);
 void vlog_log(log_level level, const char *file, int line, const char *fmt,
@@ -35,4 +87,17 @@ void vlog_log(log_level level, const char *file, int line, const char *fmt,
 
 err_t logger_start();
 
+/*
+ * Switches to async mode: log_log formats the message into a record of a
+ * lock-free ring (capacity is rounded up to a power of two) and a writer
+ * thread adds timestamps and writes records in batches. Loggers have to be
+ * set up beforehand. Starting twice is a no-op.
+ */
+err_t log_start_async(size_t capacity);
+// blocks until every record pushed so far is written and flushed
+void log_flush(void);
+// waits for log_log calls already pushing, drains the ring and joins the
+// writer, logging is synchronous afterwards
+void log_stop_async(void);
+
 #endif
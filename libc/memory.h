@@ -7,4 +7,78 @@
 void vilka(char const *restrict_format, ...);
 int rerealloc(void **ptr, size_t size);
 
-#endif
\ No newline at end of file
+/*
+ * Tracked allocator used by libc containers. Every block remembers its size
+ * and subsystem, so counters stay exact without a help from the caller.
+ * Blocks from memory_* functions must be released with memory_free() and
+ * never with free(), and vice versa.
+ */
+typedef enum {
+    MEM_OTHER,
+    MEM_STRING,
+    MEM_LIST,
+    MEM_STACK,
+    MEM_HASH_TABLE,
+    MEM_ARENA,
+    MEM_SUBSYSTEMS_COUNT
+} memory_subsystem;
+
+typedef struct {
+    size_t allocations;
+    size_t reallocations;
+    size_t frees;
+    size_t bytes;  // requested by allocations and reallocations
+    size_t live_bytes;
+    size_t peak_live_bytes;
+} memory_counters;
+
+void *memory_alloc(memory_subsystem subsystem, size_t size);
+void *memory_calloc(memory_subsystem subsystem, size_t count, size_t size);
+// block keeps its subsystem, NULL ptr is allocated in the given one
+void *memory_realloc(memory_subsystem subsystem, void *ptr, size_t size);
+void memory_free(void *ptr);
+
+const char *memory_subsystem_name(memory_subsystem subsystem);
+// MEM_SUBSYSTEMS_COUNT gives counters of all subsystems together. Every
+// field is exact on its own, but while other threads allocate the fields
+// are not a snapshot of one moment
+void memory_get_counters(memory_subsystem subsystem, memory_counters *counters);
+// starts new peak measurement from current live bytes
+void memory_reset_peaks(void);
+
+/*
+ * Bump allocator for data that dies together (everything of one line).
+ * Blocks are kept by memory_arena_reset() and reused, so a warmed up arena
+ * does not touch the heap. Arena memory is never passed to memory_free().
+ */
+#define MEMORY_ARENA_BLOCK_SIZE (16 * 1024)
+
+typedef struct memory_arena_block {
+    struct memory_arena_block *next;
+    size_t capacity;
+    size_t used;
+} memory_arena_block;
+
+typedef struct {
+    memory_arena_block *first;
+    memory_arena_block *current;
+    size_t block_size;
+} memory_arena;
+
+// position to come back to with memory_arena_rewind()
+typedef struct {
+    memory_arena_block *block;
+    size_t used;
+} memory_arena_mark;
+
+int memory_arena_init(memory_arena **arena, size_t block_size);
+void memory_arena_free(memory_arena *arena);
+void *memory_arena_alloc(memory_arena *arena, size_t size);
+// grows in place when ptr is the latest allocation, copies otherwise
+void *memory_arena_realloc(memory_arena *arena, void *ptr, size_t old_size,
+                           size_t new_size);
+void memory_arena_reset(memory_arena *arena);
+memory_arena_mark memory_arena_get_mark(const memory_arena *arena);
+void memory_arena_rewind(memory_arena *arena, memory_arena_mark mark);
+
+#endif
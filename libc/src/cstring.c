@@ -1,33 +1,67 @@
 #include "../cstring.h"
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "../errors.h"
+#include "../hash.h"
+#include "../memory.h"
+
+#define __cstring_forget_hash(str) (__cstring_string_to_base(str)->hash = 0)
 
 String string_init() {
-    String_metadata_t *str_p = (String_metadata_t *)malloc(
-        (sizeof(char) * STRING_BASE_CAPACITY) + (sizeof(String_metadata_t)));
+    return string_init_with_capacity(STRING_BASE_CAPACITY);
+}
+
+String string_init_with_capacity(size_t capacity) {
+    String_metadata_t *str_p = (String_metadata_t *)memory_alloc(
+        MEM_STRING, (sizeof(char) * capacity) + (sizeof(String_metadata_t)));
     if (str_p == NULL) {
         return NULL;
     }
     str_p->length = 0;
+    str_p->hash = 0;
 
-    str_p->capacity = STRING_BASE_CAPACITY;
+    str_p->capacity = capacity;
     return __cstring_base_to_string(str_p);
 }
 
 String string_from(const char *str) {
-    int length = strlen(str);
-    String_metadata_t *str_p = (String_metadata_t *)malloc(
-        (sizeof(char) * length) + (sizeof(String_metadata_t)));
+    return string_from_slice(str, strlen(str));
+}
+
+// short strings get base capacity, so the first append doesn't realloc
+String string_from_slice(const char *bytes, size_t length) {
+    String str = string_init_with_capacity(
+        length < STRING_BASE_CAPACITY ? STRING_BASE_CAPACITY : length);
+    if (str == NULL) {
+        return NULL;
+    }
+    if (length > 0) {
+        memcpy(str, bytes, length * sizeof(char));
+    }
+    __cstring_string_to_base(str)->length = length;
+    return str;
+}
+
+String string_arena_copy(memory_arena *arena, const char *bytes,
+                         size_t length) {
+    if (arena == NULL || (bytes == NULL && length > 0)) {
+        return NULL;
+    }
+    String_metadata_t *str_p = (String_metadata_t *)memory_arena_alloc(
+        arena, (sizeof(char) * length) + (sizeof(String_metadata_t)));
     if (str_p == NULL) {
         return NULL;
     }
     str_p->length = length;
     str_p->capacity = length;
-    memcpy(__cstring_base_to_string(str_p), str, length * sizeof(char));
+    str_p->hash = 0;
+    if (length > 0) {
+        memcpy(__cstring_base_to_string(str_p), bytes, length * sizeof(char));
+    }
     return __cstring_base_to_string(str_p);
 }
 
@@ -35,7 +69,15 @@ void string_free(const String str) {
     if (str == NULL) {
         return;
     }
-    free((void *)__cstring_string_to_base(str));
+    memory_free((void *)__cstring_string_to_base(str));
+}
+
+void string_clear(String str) {
+    if (str == NULL) {
+        return;
+    }
+    __cstring_string_to_base(str)->length = 0;
+    __cstring_forget_hash(str);
 }
 
 int string_add(String *str, char c) {
@@ -44,11 +86,7 @@ int string_add(String *str, char c) {
     }
 
     if (string_len(*str) >= string_cap(*str)) {
-        size_t new_capacity = (string_cap(*str) == 0)
-                                  ? 1
-                                  : string_cap(*str) * STRING_GROWTH_FACTOR;
-
-        int err = string_grow(str, new_capacity);
+        int err = string_reserve(str, string_len(*str) + 1);
         if (err) {
             return err;
         }
@@ -56,20 +94,12 @@ int string_add(String *str, char c) {
 
     (*str)[string_len(*str)] = c;
     __cstring_string_to_base(*str)->length++;
+    __cstring_forget_hash(*str);
 
     return EXIT_SUCCESS;
 }
 
-void string_print(String str) {
-    int i;
-    if (string_len(str) == 0) {
-        printf("(nil)");
-        return;
-    }
-    for (i = 0; i < string_len(str); ++i) {
-        putc(str[i], stdout);
-    }
-}
+void string_print(String str) { string_fprint(stdout, str); }
 
 int string_cmp(String str1, String str2) {
     size_t len1, len2;
@@ -143,6 +173,7 @@ int string_cpy(String *dest, const String *src) {
     }
     memcpy(*dest, *src, length);
     __cstring_string_to_base(*dest)->length = length;
+    __cstring_forget_hash(*dest);
     return EXIT_SUCCESS;
 }
 
@@ -161,43 +192,22 @@ int string_cpy_c(String *dest, const char *src) {
     }
     memcpy(*dest, src, length);
     __cstring_string_to_base(*dest)->length = length;
+    __cstring_forget_hash(*dest);
     return EXIT_SUCCESS;
 }
 
 int string_cat(String *dest, const String *src) {
-    int err;
-    int length = string_len(*src) + string_len(*dest);
     if (dest == NULL || src == NULL) {
         return DEREFERENCING_NULL_PTR;
     }
-    if (string_cap(*dest) < length) {
-        err = string_grow(dest, length);
-        if (err) {
-            return err;
-        }
-    }
-    memcpy(*dest + string_len(*dest), *src, string_len(*src));
-    __cstring_string_to_base(*dest)->length = length;
-    return EXIT_SUCCESS;
+    return string_append(dest, *src, string_len(*src));
 }
 
 int string_cat_c(String *dest, const char *src) {
-    int err;
-    int length = strlen(src) + string_len(*dest);
     if (dest == NULL || src == NULL) {
         return DEREFERENCING_NULL_PTR;
     }
-
-    if (string_cap(*dest) < length) {
-        err = string_grow(dest, length);
-        if (err) {
-            return err;
-        }
-    }
-    memcpy((*dest) + string_len(*dest), src, strlen(src));
-    __cstring_string_to_base(*dest)->length = length;
-
-    return EXIT_SUCCESS;
+    return string_append(dest, src, strlen(src));
 }
 
 int string_str(String haystack, String needle) {
@@ -283,8 +293,8 @@ int string_grow(String *str, size_t new_size) {
     if (current_size == new_size) {
         return EXIT_SUCCESS;
     }
-    for_realloc = (String_metadata_t *)realloc(
-        __cstring_string_to_base(*str),
+    for_realloc = (String_metadata_t *)memory_realloc(
+        MEM_STRING, __cstring_string_to_base(*str),
         (new_size * sizeof(char)) + sizeof(String_metadata_t));
 
     if (for_realloc == NULL) {
@@ -297,6 +307,7 @@ int string_grow(String *str, size_t new_size) {
     if (new_size < current_size) {
         for_realloc->length = new_size;
         for_realloc->capacity = new_size;
+        for_realloc->hash = 0;
     }
 
     return EXIT_SUCCESS;
@@ -305,23 +316,237 @@ int string_grow(String *str, size_t new_size) {
 void string_fprint(FILE *fout, const String str) {
     size_t i;
     if (string_len(str) == 0) {
+        fprintf(fout, "(nil)");
         return;
     }
     for (i = 0; i < string_len(str); ++i) {
-        fputc(str[i], fout);
+        putc(str[i], fout);
+    }
+}
+
+int string_reserve(String *str, size_t capacity) {
+    if (str == NULL || *str == NULL) {
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    size_t new_capacity = string_cap(*str);
+
+    if (capacity <= new_capacity) {
+        return EXIT_SUCCESS;
+    }
+    if (new_capacity < STRING_BASE_CAPACITY) {
+        new_capacity = STRING_BASE_CAPACITY;
+    }
+    while (new_capacity < capacity) {
+        new_capacity *= STRING_GROWTH_FACTOR;
+    }
+    return string_grow(str, new_capacity);
+}
+
+int string_append(String *str, const char *bytes, size_t length) {
+    if (str == NULL || *str == NULL || (bytes == NULL && length > 0)) {
+        return DEREFERENCING_NULL_PTR;
+    }
+    if (length == 0) {
+        return EXIT_SUCCESS;
+    }
+
+    size_t old_length = string_len(*str);
+    int err = string_reserve(str, old_length + length);
+    if (err) {
+        return err;
+    }
+    memcpy(*str + old_length, bytes, length * sizeof(char));
+    __cstring_string_to_base(*str)->length = old_length + length;
+    __cstring_forget_hash(*str);
+
+    return EXIT_SUCCESS;
+}
+
+int string_shrink_to_fit(String *str) {
+    if (str == NULL || *str == NULL) {
+        return DEREFERENCING_NULL_PTR;
     }
+    return string_grow(str, string_len(*str));
 }
 
 err_t string_add_str(String *str, const char *s) {
     if (str == NULL || s == NULL) {
         return DEREFERENCING_NULL_PTR;
     }
-    while (*s) {
-        err_t err = string_add(str, *s);
+    return string_append(str, s, strlen(s));
+}
+
+size_t string_hash(const String str) {
+    if (str == NULL) {
+        return 0;
+    }
+
+    String_metadata_t *base = __cstring_string_to_base(str);
+
+    if (base->hash == 0) {
+        base->hash = (size_t)wyhash(str, base->length, HASH_DEFAULT_SEED);
+    }
+    return base->hash;
+}
+
+static string_pool *global_pool = NULL;
+
+int string_pool_init(string_pool **pool) {
+    if (pool == NULL) {
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    string_pool *p =
+        (string_pool *)memory_alloc(MEM_STRING, sizeof(string_pool));
+    if (p == NULL) {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    p->strings = (String *)memory_alloc(
+        MEM_STRING, STRING_POOL_BASE_CAPACITY * sizeof(String));
+    if (p->strings == NULL) {
+        memory_free(p);
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    p->index = (size_t *)memory_alloc(
+        MEM_STRING, 2 * STRING_POOL_BASE_CAPACITY * sizeof(size_t));
+    if (p->index == NULL) {
+        memory_free(p->strings);
+        memory_free(p);
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    memset(p->index, 0xFF, 2 * STRING_POOL_BASE_CAPACITY * sizeof(size_t));
+    p->count = 0;
+    p->capacity = STRING_POOL_BASE_CAPACITY;
+    p->index_capacity = 2 * STRING_POOL_BASE_CAPACITY;
+
+    *pool = p;
+
+    return EXIT_SUCCESS;
+}
+
+void string_pool_free(string_pool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    size_t i = 0;
+
+    for (i = 0; i < pool->count; ++i) {
+        string_free(pool->strings[i]);
+    }
+    memory_free(pool->strings);
+    memory_free(pool->index);
+    memory_free(pool);
+}
+
+void string_pool_clear(string_pool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    size_t i = 0;
+
+    for (i = 0; i < pool->count; ++i) {
+        string_free(pool->strings[i]);
+    }
+    memset(pool->index, 0xFF, pool->index_capacity * sizeof(size_t));
+    pool->count = 0;
+}
+
+// index is kept at most half full, codes come from the cached hashes
+static int string_pool_grow_index(string_pool *pool) {
+    size_t new_capacity = pool->index_capacity * 2, i = 0, slot = 0;
+    size_t *index =
+        (size_t *)memory_alloc(MEM_STRING, new_capacity * sizeof(size_t));
+    if (index == NULL) {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    memset(index, 0xFF, new_capacity * sizeof(size_t));
+
+    for (i = 0; i < pool->count; ++i) {
+        slot = string_hash(pool->strings[i]) & (new_capacity - 1);
+        while (index[slot] != SIZE_MAX) {
+            slot = (slot + 1) & (new_capacity - 1);
+        }
+        index[slot] = i;
+    }
+
+    memory_free(pool->index);
+    pool->index = index;
+    pool->index_capacity = new_capacity;
+
+    return EXIT_SUCCESS;
+}
+
+int string_pool_intern(string_pool *pool, const char *bytes, size_t length,
+                       size_t *id) {
+    if (pool == NULL || id == NULL || (bytes == NULL && length != 0)) {
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    size_t hash = (size_t)wyhash(bytes, length, HASH_DEFAULT_SEED);
+    size_t mask = pool->index_capacity - 1, slot = hash & mask;
+    String candidate = NULL, *strings = NULL;
+    int err = 0;
+
+    for (; pool->index[slot] != SIZE_MAX; slot = (slot + 1) & mask) {
+        candidate = pool->strings[pool->index[slot]];
+        if (string_hash(candidate) == hash &&
+            string_len(candidate) == length &&
+            memcmp(candidate, bytes, length) == 0) {
+            *id = pool->index[slot];
+            return EXIT_SUCCESS;
+        }
+    }
+
+    if (pool->count == pool->capacity) {
+        strings = (String *)memory_realloc(
+            MEM_STRING, pool->strings, pool->capacity * 2 * sizeof(String));
+        if (strings == NULL) {
+            return MEMORY_ALLOCATION_ERROR;
+        }
+        pool->strings = strings;
+        pool->capacity *= 2;
+    }
+    if ((pool->count + 1) * 2 > pool->index_capacity) {
+        err = string_pool_grow_index(pool);
         if (err) {
             return err;
         }
-        s++;
+        mask = pool->index_capacity - 1;
+        for (slot = hash & mask; pool->index[slot] != SIZE_MAX;
+             slot = (slot + 1) & mask);
     }
+
+    candidate = string_from_slice(bytes, length);
+    if (candidate == NULL) {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    __cstring_string_to_base(candidate)->hash = hash;
+
+    pool->strings[pool->count] = candidate;
+    pool->index[slot] = pool->count;
+    *id = pool->count++;
+
     return EXIT_SUCCESS;
 }
+
+String string_pool_string(const string_pool *pool, size_t id) {
+    if (pool == NULL || id >= pool->count) {
+        return NULL;
+    }
+    return pool->strings[id];
+}
+
+string_pool *string_pool_global() {
+    if (global_pool == NULL && string_pool_init(&global_pool)) {
+        global_pool = NULL;
+    }
+    return global_pool;
+}
+
+void string_pool_global_free() {
+    string_pool_free(global_pool);
+    global_pool = NULL;
+}
@@ -0,0 +1,97 @@
+#include "../hash.h"
+
+#include <string.h>
+
+static const uint64_t wyhash_secret[4] = {
+    0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL,
+    0x589965cc75374cc3ULL};
+
+// a and b become the low and high halves of a * b
+static void wyhash_mum(uint64_t *a, uint64_t *b) {
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32;
+    uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static uint64_t wyhash_mix(uint64_t a, uint64_t b) {
+    wyhash_mum(&a, &b);
+    return a ^ b;
+}
+
+// unaligned reads, memcpy compiles to a single load
+static uint64_t wyhash_read8(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t wyhash_read4(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// 1 to 3 bytes, every byte is read at least once
+static uint64_t wyhash_read3(const unsigned char *p, size_t len) {
+    return (((uint64_t)p[0]) << 16) | (((uint64_t)p[len >> 1]) << 8) |
+           p[len - 1];
+}
+
+uint64_t wyhash(const void *data, size_t len, uint64_t seed) {
+    const unsigned char *p = (const unsigned char *)data;
+    const uint64_t *s = wyhash_secret;
+    uint64_t a = 0, b = 0, see1 = 0, see2 = 0;
+    size_t i = len;
+
+    seed ^= wyhash_mix(seed ^ s[0], s[1]);
+    if (len <= 16) {
+        if (len >= 4) {
+            // two overlapping pairs of 4 byte reads cover 4..16 bytes
+            a = (wyhash_read4(p) << 32) | wyhash_read4(p + ((len >> 3) << 2));
+            b = (wyhash_read4(p + len - 4) << 32) |
+                wyhash_read4(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = wyhash_read3(p, len);
+        }
+    } else {
+        if (i > 48) {
+            see1 = seed;
+            see2 = seed;
+            do {
+                seed = wyhash_mix(wyhash_read8(p) ^ s[1],
+                                  wyhash_read8(p + 8) ^ seed);
+                see1 = wyhash_mix(wyhash_read8(p + 16) ^ s[2],
+                                  wyhash_read8(p + 24) ^ see1);
+                see2 = wyhash_mix(wyhash_read8(p + 32) ^ s[3],
+                                  wyhash_read8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed =
+                wyhash_mix(wyhash_read8(p) ^ s[1], wyhash_read8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wyhash_read8(p + i - 16);
+        b = wyhash_read8(p + i - 8);
+    }
+
+    a ^= s[1];
+    b ^= seed;
+    wyhash_mum(&a, &b);
+    return wyhash_mix(a ^ s[0] ^ len, b ^ s[1]);
+}
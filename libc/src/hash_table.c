@@ -6,52 +6,333 @@
 #include <string.h>
 #include <strings.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../hash.h"
+#include "../memory.h"
+
+#define HASH_TABLE_EMPTY ((unsigned char)0x80)
+#define HASH_TABLE_DELETED ((unsigned char)0xFE)
+
+// pointer alignment, wider only when key or value may need it
+static size_t hash_table_alignment(size_t key_size, size_t value_size) {
+    if (key_size >= sizeof(long double) || value_size >= sizeof(long double)) {
+        return sizeof(long double);
+    }
+    return sizeof(void *);
+}
+
+static size_t hash_table_round_up(size_t n, size_t alignment) {
+    return (n + alignment - 1) / alignment * alignment;
+}
+
+// at most 7/8 of the slots are taken by entries and tombstones
+static size_t hash_table_max_load(size_t capacity) {
+    return capacity - capacity / 8;
+}
+
+// smallest capacity that holds expected entries without a resize
+static size_t hash_table_capacity_for(size_t expected) {
+    size_t capacity = HASH_TABLE_GROUP_WIDTH;
+
+    while (hash_table_max_load(capacity) < expected) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+// table hashes may be weak in high bits, the tag comes from there
+static size_t hash_table_mix(size_t hash) {
+    return (size_t)hash_mix64((uint64_t)hash);
+}
+
+static size_t hash_table_hash(const hash_table *ht, const void *key) {
+    return hash_table_mix(ht->hash(key, ht->key_size, SIZE_MAX));
+}
+
+static unsigned char hash_table_tag(size_t hash) {
+    return (unsigned char)(hash & 0x7F);
+}
+
+// slots start with the full hash code of their key
+static unsigned char *hash_table_slot(const hash_table *ht,
+                                      const hash_table_storage *storage,
+                                      size_t index) {
+    return storage->slots + index * ht->slot_size;
+}
+
+// bit i is set when control byte i of the group equals tag
+static unsigned hash_table_group_match(const unsigned char *group,
+                                       unsigned char tag) {
+#ifdef __SSE2__
+    __m128i bytes = _mm_loadu_si128((const __m128i *)group);
+    return (unsigned)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)tag)));
+#else
+    unsigned mask = 0, i = 0;
+    for (i = 0; i < HASH_TABLE_GROUP_WIDTH; ++i) {
+        if (group[i] == tag) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+// empty and deleted bytes are the only ones with the high bit set
+static unsigned hash_table_group_match_free(const unsigned char *group) {
+#ifdef __SSE2__
+    return (unsigned)_mm_movemask_epi8(
+        _mm_loadu_si128((const __m128i *)group));
+#else
+    unsigned mask = 0, i = 0;
+    for (i = 0; i < HASH_TABLE_GROUP_WIDTH; ++i) {
+        if (group[i] & 0x80) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+static err_t hash_table_find_in(const hash_table *ht,
+                                const hash_table_storage *storage,
+                                const void *key, size_t hash, size_t *index) {
+    size_t groups_mask = storage->capacity / HASH_TABLE_GROUP_WIDTH - 1;
+    size_t group = (hash >> 7) & groups_mask, probe = 0, slot = 0;
+    const unsigned char *control = NULL;
+    unsigned mask = 0, bit = 0;
+
+    for (probe = 0; probe <= groups_mask; ++probe) {
+        control = storage->control + group * HASH_TABLE_GROUP_WIDTH;
+        mask = hash_table_group_match(control, hash_table_tag(hash));
+        while (mask != 0) {
+            bit = (unsigned)__builtin_ctz(mask);
+            slot = group * HASH_TABLE_GROUP_WIDTH + bit;
+            // the stored code rejects tag collisions without the comparer
+            if (*(size_t *)hash_table_slot(ht, storage, slot) == hash &&
+                ht->keys_comparer(
+                    hash_table_slot(ht, storage, slot) + ht->key_offset,
+                    key) == 0) {
+                *index = slot;
+                return EXIT_SUCCESS;
+            }
+            mask &= mask - 1;
+        }
+        if (hash_table_group_match(control, HASH_TABLE_EMPTY) != 0) {
+            return KEY_NOT_FOUND;
+        }
+        group = (group + probe + 1) & groups_mask;  // triangular probing
+    }
+
+    return KEY_NOT_FOUND;
+}
+
+// looks in the current storage, then in the one being migrated from
+static err_t hash_table_find(hash_table *ht, const void *key, size_t hash,
+                             hash_table_storage **storage, size_t *index) {
+    if (ht->current.control == NULL) {
+        return KEY_NOT_FOUND;
+    }
+
+    err_t err = hash_table_find_in(ht, &ht->current, key, hash, index);
+    if (err == EXIT_SUCCESS) {
+        *storage = &ht->current;
+        return EXIT_SUCCESS;
+    }
+    if (ht->previous.control == NULL) {
+        return err;
+    }
+    err = hash_table_find_in(ht, &ht->previous, key, hash, index);
+    if (err == EXIT_SUCCESS) {
+        *storage = &ht->previous;
+    }
+    return err;
+}
+
+// the caller guarantees there is a free slot
+static size_t hash_table_find_free(const hash_table_storage *storage,
+                                   size_t hash) {
+    size_t groups_mask = storage->capacity / HASH_TABLE_GROUP_WIDTH - 1;
+    size_t group = (hash >> 7) & groups_mask, probe = 0;
+    unsigned mask = 0;
+
+    for (probe = 0;; ++probe) {
+        mask = hash_table_group_match_free(storage->control +
+                                           group * HASH_TABLE_GROUP_WIDTH);
+        if (mask != 0) {
+            return group * HASH_TABLE_GROUP_WIDTH +
+                   (size_t)__builtin_ctz(mask);
+        }
+        group = (group + probe + 1) & groups_mask;
+    }
+}
+
+// claims a slot of the current storage for hash, returns the slot. Slots of
+// migrated entries are reserved when the resize begins
+static unsigned char *hash_table_claim(hash_table *ht, size_t hash,
+                                       int reserved) {
+    size_t index = hash_table_find_free(&ht->current, hash);
+
+    if (!reserved && ht->current.control[index] == HASH_TABLE_EMPTY) {
+        ht->growth_left--;
+    }
+    ht->current.control[index] = hash_table_tag(hash);
+
+    return hash_table_slot(ht, &ht->current, index);
+}
+
+static void hash_table_dispose_entry(hash_table *ht,
+                                     const hash_table_storage *storage,
+                                     size_t index) {
+    hash_table_bucket entry;
+    unsigned char *slot = hash_table_slot(ht, storage, index);
+
+    if (ht->bucket_destructor != NULL) {
+        entry.key = slot + ht->key_offset;
+        entry.value = slot + ht->value_offset;
+        ht->bucket_destructor(&entry);
+    }
+}
+
+// control bytes and slots share one block, capacity keeps slots aligned
+static err_t hash_table_allocate(const hash_table *ht, size_t capacity,
+                                 hash_table_storage *storage) {
+    unsigned char *block = (unsigned char *)memory_alloc(
+        MEM_HASH_TABLE, capacity + capacity * ht->slot_size);
+    if (block == NULL) {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    memset(block, HASH_TABLE_EMPTY, capacity);
+    storage->control = block;
+    storage->slots = block + capacity;
+    storage->capacity = capacity;
+
+    return EXIT_SUCCESS;
+}
+
+// moves up to limit previous slots, previous storage goes once it is empty
+static void hash_table_migrate(hash_table *ht, size_t limit) {
+    hash_table_storage *previous = &ht->previous;
+    unsigned char *slot = NULL;
+    size_t end = 0;
+
+    if (previous->control == NULL) {
+        return;
+    }
+
+    end = previous->capacity - ht->migrated > limit ? ht->migrated + limit
+                                                    : previous->capacity;
+    for (; ht->migrated < end; ++ht->migrated) {
+        if (previous->control[ht->migrated] & 0x80) {
+            continue;
+        }
+        slot = hash_table_slot(ht, previous, ht->migrated);
+        memcpy(hash_table_claim(ht, *(size_t *)slot, 1), slot,
+               ht->slot_size);
+        // keeps probe sequences of previous intact for unmoved entries
+        previous->control[ht->migrated] = HASH_TABLE_DELETED;
+    }
+
+    if (ht->migrated == previous->capacity) {
+        memory_free(previous->control);
+        previous->control = NULL;
+        previous->slots = NULL;
+        previous->capacity = 0;
+    }
+}
+
+// switches to new storage, entries move over in hash_table_migrate
+static err_t hash_table_begin_resize(hash_table *ht, size_t new_capacity) {
+    hash_table_storage storage;
+    err_t err = 0;
+
+    hash_table_migrate(ht, SIZE_MAX);  // one resize at a time
+
+    // probing masks group numbers, so capacity stays a power of two
+    if (new_capacity < HASH_TABLE_GROUP_WIDTH ||
+        (new_capacity & (new_capacity - 1)) != 0 ||
+        ht->size > hash_table_max_load(new_capacity)) {
+        return INVALID_INPUT_DATA;
+    }
+
+    err = hash_table_allocate(ht, new_capacity, &storage);
+    if (err) {
+        return err;
+    }
+
+    ht->previous = ht->current;
+    ht->current = storage;
+    ht->migrated = 0;
+    // every entry is still in previous, their slots are taken up front so
+    // inserts during the migration can't leave them without room
+    ht->growth_left = hash_table_max_load(new_capacity) - ht->size;
+
+    return EXIT_SUCCESS;
+}
+
+// grows, shrinks or drops tombstones, in steps when the table is incremental
+static err_t hash_table_rebuild(hash_table *ht, size_t new_capacity) {
+    err_t err = hash_table_begin_resize(ht, new_capacity);
+    if (err) {
+        return err;
+    }
+    if (!ht->incremental) {
+        hash_table_migrate(ht, SIZE_MAX);
+    }
+
+    return EXIT_SUCCESS;
+}
+
 err_t hash_table_init(
     hash_table **ht, int (*keys_comparer)(const void *, const void *),
     size_t (*hash)(const void *key, size_t key_size, size_t capacity),
     size_t key_size, size_t value_size, void (*bucket_destructor)(void *)) {
-    if (ht == NULL || keys_comparer == NULL || hash == NULL ||
-        bucket_destructor == NULL) {
+    return hash_table_init_with_hint(ht, keys_comparer, hash, key_size,
+                                     value_size, bucket_destructor,
+                                     hash_table_max_load(HASHSIZE));
+}
+
+err_t hash_table_init_with_hint(
+    hash_table **ht, int (*keys_comparer)(const void *, const void *),
+    size_t (*hash)(const void *key, size_t key_size, size_t capacity),
+    size_t key_size, size_t value_size, void (*bucket_destructor)(void *),
+    size_t expected_size) {
+    if (ht == NULL || keys_comparer == NULL) {
         return DEREFERENCING_NULL_PTR;
     }
 
-    hash_table *table = *ht;
-    err_t err = 0;
-    size_t i = 0, j = 0;
+    hash_table *table = NULL;
+    size_t alignment = hash_table_alignment(key_size, value_size);
 
-    table = (hash_table *)malloc(sizeof(hash_table));
+    table = (hash_table *)memory_alloc(MEM_HASH_TABLE, sizeof(hash_table));
     if (table == NULL) {
         return MEMORY_ALLOCATION_ERROR;
     }
 
-    table->buckets = (u_list **)calloc(  // all ptr's should be NULL
-        HASHSIZE, sizeof(u_list *));
-    if (table->buckets == NULL) {
-        free(table);
-        return MEMORY_ALLOCATION_ERROR;
-    }
-
-    for (i = 0; i < HASHSIZE; ++i) {
-        err = u_list_init(&(table->buckets[i]), sizeof(hash_table_bucket),
-                          bucket_destructor);
-        if (err) {
-            for (j = 0; j < i; ++j) {
-                u_list_free(table->buckets[j]);
-            }
-            free(table->buckets);
-            free(table);
-            return err;
-        }
-    }
-
+    table->current.control = NULL;  // allocated by the first insert
+    table->current.slots = NULL;
+    table->current.capacity = 0;
+    table->initial_capacity = hash_table_capacity_for(expected_size);
+    table->previous.control = NULL;
+    table->previous.slots = NULL;
+    table->previous.capacity = 0;
+    table->migrated = 0;
+    table->incremental = 0;
     table->size = 0;
-    table->min_chain_length = 0;
-    table->max_chain_length = 0;
-    table->capacity = HASHSIZE;
+    table->growth_left = 0;
     table->key_size = key_size;
     table->value_size = value_size;
+    // slots hold the hash code, the key, then the value
+    table->key_offset = hash_table_round_up(sizeof(size_t), alignment);
+    table->value_offset =
+        table->key_offset + hash_table_round_up(key_size, alignment);
+    table->slot_size =
+        hash_table_round_up(table->value_offset + value_size, alignment);
     table->keys_comparer = keys_comparer;
-    table->hash = hash;
+    table->hash = hash != NULL ? hash : wyhash_hash;
     table->bucket_destructor = bucket_destructor;
 
     *ht = table;
@@ -59,19 +340,60 @@ err_t hash_table_init(
     return EXIT_SUCCESS;
 }
 
+err_t hash_table_set_incremental(hash_table *ht, int enable) {
+    if (ht == NULL) {
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    ht->incremental = enable;
+    if (!enable) {
+        hash_table_migrate(ht, SIZE_MAX);
+    }
+
+    return EXIT_SUCCESS;
+}
+
 void hash_table_free(hash_table *ht) {
     if (ht == NULL) {
         return;
     }
 
+    hash_table_clear(ht);
+    memory_free(ht->current.control);
+    memory_free(ht);
+}
+
+err_t hash_table_clear(hash_table *ht) {
+    if (ht == NULL) {
+        return DEREFERENCING_NULL_PTR;
+    }
+
     size_t i = 0;
-    hash_table_bucket *bucket = NULL, *temp = NULL;
 
-    for (i = 0; i < ht->capacity; ++i) {
-        u_list_free(ht->buckets[i]);
+    for (i = 0; i < ht->current.capacity; ++i) {
+        if (!(ht->current.control[i] & 0x80)) {
+            hash_table_dispose_entry(ht, &ht->current, i);
+        }
+    }
+    for (i = 0; i < ht->previous.capacity; ++i) {
+        if (!(ht->previous.control[i] & 0x80)) {
+            hash_table_dispose_entry(ht, &ht->previous, i);
+        }
+    }
+    memory_free(ht->previous.control);
+    ht->previous.control = NULL;
+    ht->previous.slots = NULL;
+    ht->previous.capacity = 0;
+    ht->migrated = 0;
+
+    // current storage is kept for reuse
+    if (ht->current.control != NULL) {
+        memset(ht->current.control, HASH_TABLE_EMPTY, ht->current.capacity);
     }
-    free(ht->buckets);
-    free(ht);
+    ht->size = 0;
+    ht->growth_left = hash_table_max_load(ht->current.capacity);
+
+    return EXIT_SUCCESS;
 }
 
 err_t hash_table_set(hash_table *ht, const void *key, const void *value) {
@@ -79,66 +401,45 @@ err_t hash_table_set(hash_table *ht, const void *key, const void *value) {
         return DEREFERENCING_NULL_PTR;
     }
 
-    size_t index = ht->hash(key, ht->key_size, ht->capacity);
-    u_list *bucket = ht->buckets[index];
-    hash_table_bucket *existing_bucket = NULL, new_bucket;
-    hash_table_bucket search;
-    u_list_node *node = NULL;
+    size_t hash = hash_table_hash(ht, key), index = 0, capacity = 0;
+    hash_table_storage *storage = NULL;
+    unsigned char *slot = NULL;
     err_t err = 0;
-    double load_factor = 0, chain_length_factor = 0;
 
-    search.key = (void *)key;
+    hash_table_migrate(ht, HASH_TABLE_MIGRATE_SLOTS);
 
-    err = u_list_get_node_by_value(bucket, &search, ht->keys_comparer, &node);
-    if (err != EXIT_SUCCESS && err != NO_SUCH_ENTRY_IN_COLLECTION) {
-        return err;
-    }
+    err = hash_table_find(ht, key, hash, &storage, &index);
     if (err == EXIT_SUCCESS) {
-        existing_bucket = (hash_table_bucket *)node->data;
-        memcpy(existing_bucket->value, value, ht->value_size);
+        memcpy(hash_table_slot(ht, storage, index) + ht->value_offset, value,
+               ht->value_size);
         return EXIT_SUCCESS;
     }
-    // key not found
-    new_bucket.key = malloc(ht->key_size);
-    if (new_bucket.key == NULL) {
-        return MEMORY_ALLOCATION_ERROR;
-    }
-    new_bucket.value = malloc(ht->value_size);
-    if (new_bucket.value == NULL) {
-        free(new_bucket.key);
-        return MEMORY_ALLOCATION_ERROR;
-    }
-
-    memcpy(new_bucket.key, key, ht->key_size);
-    memcpy(new_bucket.value, value, ht->value_size);
 
-    err = u_list_insert(bucket, 0, &new_bucket);
-    if (err) {
-        ht->bucket_destructor(&new_bucket);
-        return err;
-    }
-
-    ht->size++;
-
-    if (bucket->size > ht->max_chain_length) {
-        ht->max_chain_length = bucket->size;
-    }
-
-    err = hash_table_get_load_factor(ht, &load_factor);
-    if (err) {
-        return err;
-    }
-    err = hash_table_get_chain_length_factor(ht, &chain_length_factor);
-    if (err) {
-        return err;
-    }
-    if (load_factor > 0.75 || chain_length_factor >= 2.0) {
-        err = hash_table_resize(ht, HASH_TABLE_GROWTH_FACTOR);
+    if (ht->current.control == NULL) {
+        err = hash_table_allocate(ht, ht->initial_capacity, &ht->current);
+        if (err) {
+            return err;
+        }
+        ht->growth_left = hash_table_max_load(ht->initial_capacity);
+    }
+    if (ht->growth_left == 0) {
+        // mostly tombstones: rebuild at the same size, otherwise grow
+        capacity = ht->current.capacity;
+        err = hash_table_rebuild(
+            ht, ht->size * 2 < hash_table_max_load(capacity)
+                    ? capacity
+                    : capacity * HASH_TABLE_GROWTH_FACTOR);
         if (err) {
             return err;
         }
     }
 
+    slot = hash_table_claim(ht, hash, 0);
+    *(size_t *)slot = hash;
+    memcpy(slot + ht->key_offset, key, ht->key_size);
+    memcpy(slot + ht->value_offset, value, ht->value_size);
+    ht->size++;
+
     return EXIT_SUCCESS;
 }
 
@@ -148,28 +449,16 @@ err_t hash_table_get(hash_table *ht, const void *key,
         return DEREFERENCING_NULL_PTR;
     }
 
-    size_t index = ht->hash(key, ht->key_size, ht->capacity);
-    u_list *bucket = ht->buckets[index];
-    hash_table_bucket search;
-    u_list_node *node = NULL;
-    err_t err;
+    hash_table_storage *storage = NULL;
+    size_t index = 0;
+    err_t err = 0;
 
-    if (bucket->size == 1) {  // good case
-        *value_placeholder = ((hash_table_bucket *)bucket->first->data)->value;
-        return EXIT_SUCCESS;
-    }
-    // bad case :(
-    search.key = (void *)key;
-    err = u_list_get_node_by_value(bucket, &search, ht->keys_comparer, &node);
-    if (err != EXIT_SUCCESS && err != NO_SUCH_ENTRY_IN_COLLECTION) {
+    err = hash_table_find(ht, key, hash_table_hash(ht, key), &storage, &index);
+    if (err) {
         return err;
     }
 
-    if (err == NO_SUCH_ENTRY_IN_COLLECTION) {
-        return KEY_NOT_FOUND;
-    }
-
-    *value_placeholder = ((hash_table_bucket *)node->data)->value;
+    *value_placeholder = hash_table_slot(ht, storage, index) + ht->value_offset;
 
     return EXIT_SUCCESS;
 }
@@ -179,45 +468,42 @@ err_t hash_table_dispose(hash_table *ht, const void *key) {
         return DEREFERENCING_NULL_PTR;
     }
 
-    size_t index = ht->hash(key, ht->key_size, ht->capacity);
-    err_t err;
-    hash_table_bucket search;
-    u_list_node *node = NULL;
-    u_list *bucket = ht->buckets[index];
+    hash_table_storage *storage = NULL;
+    size_t index = 0, group = 0;
+    err_t err = 0;
     double load_factor = 0;
 
-    search.key = (void *)key;
+    hash_table_migrate(ht, HASH_TABLE_MIGRATE_SLOTS);
 
-    if (bucket->size == 1) {
-        err = u_list_delete_by_index(bucket, 0);
-        if (err != EXIT_SUCCESS || err != NO_SUCH_ENTRY_IN_COLLECTION) {
-            return err;
-        }
-        if (err == NO_SUCH_ENTRY_IN_COLLECTION) {
-            return KEY_NOT_FOUND;
-        }
+    err = hash_table_find(ht, key, hash_table_hash(ht, key), &storage, &index);
+    if (err) {
+        return err;
+    }
+    hash_table_dispose_entry(ht, storage, index);
+
+    // a probe reaching a group with an empty byte stops there anyway
+    group = index / HASH_TABLE_GROUP_WIDTH * HASH_TABLE_GROUP_WIDTH;
+    if (storage == &ht->current &&
+        hash_table_group_match(storage->control + group, HASH_TABLE_EMPTY) !=
+            0) {
+        storage->control[index] = HASH_TABLE_EMPTY;
+        ht->growth_left++;
     } else {
-        err = u_list_delete_by_value(bucket, &search, ht->keys_comparer);
-        if (err != EXIT_SUCCESS || err != NO_SUCH_ENTRY_IN_COLLECTION) {
-            return err;
-        }
-        if (err == NO_SUCH_ENTRY_IN_COLLECTION) {
-            return KEY_NOT_FOUND;
+        storage->control[index] = HASH_TABLE_DELETED;
+        if (storage == &ht->previous) {
+            ht->growth_left++;  // its reserved slot won't be needed
         }
     }
-
     ht->size--;
 
-    if (bucket->size < ht->min_chain_length) {
-        ht->min_chain_length = bucket->size;
-    }
-
     err = hash_table_get_load_factor(ht, &load_factor);
     if (err) {
         return err;
     }
-    if (load_factor < 0.25) {
-        err = hash_table_resize(ht, -HASH_TABLE_GROWTH_FACTOR);
+    if (load_factor < 0.25 && ht->current.capacity > ht->initial_capacity &&
+        ht->previous.control == NULL) {
+        err = hash_table_rebuild(
+            ht, ht->current.capacity / HASH_TABLE_SHRINK_FACTOR);
         if (err) {
             return err;
         }
@@ -230,57 +516,16 @@ err_t hash_table_resize(hash_table *ht, int size_modifier) {
     if (ht == NULL) {
         return DEREFERENCING_NULL_PTR;
     }
-
-    size_t new_capacity = ht->capacity * size_modifier, new_index = 0;
-    u_list **new_buckets = NULL, *old_bucket = NULL;
-    hash_table_bucket *entry = NULL;
-    u_list_node *node = NULL, *father = NULL;
-    size_t i = 0, j = 0;
-    err_t err = 0;
-
-    new_buckets = (u_list **)calloc(new_capacity, sizeof(u_list *));
-    if (new_buckets == NULL) {
-        return MEMORY_ALLOCATION_ERROR;
+    if (size_modifier == 0) {
+        return INVALID_INPUT_DATA;
     }
 
-    for (i = 0; i < new_capacity; ++i) {
-        err = u_list_init(&(new_buckets[i]), sizeof(hash_table_bucket),
-                          ht->bucket_destructor);
-        if (err) {
-            for (j = 0; j < i; ++j) {
-                u_list_free(new_buckets[j]);
-            }
-            free(new_buckets);
-            return err;
-        }
-    }
+    size_t capacity = ht->current.capacity;
 
-    for (i = 0; i < ht->capacity; ++i) {
-        old_bucket = ht->buckets[i];
-        node = old_bucket->first;
-        while (node != NULL) {
-            entry = node->data;
-            new_index = ht->hash(entry->key, ht->key_size, new_capacity);
-            err = u_list_insert(new_buckets[i], 0, entry);
-            if (err) {
-                for (j = 0; j < new_capacity; ++j) {
-                    u_list_free(new_buckets[j]);
-                }
-                free(new_buckets);
-                return err;
-            }
-            father = node;
-            node = node->next;
-            free(father->data);
-            free(father);
-        }
-        free(old_bucket);
-    }
-    free(ht->buckets);
-    ht->buckets = new_buckets;
-    ht->capacity = new_capacity;
-
-    return EXIT_SUCCESS;
+    // negative modifier shrinks, 1 only drops tombstones
+    return hash_table_rebuild(
+        ht, size_modifier < 0 ? capacity / (size_t)(-size_modifier)
+                              : capacity * (size_t)size_modifier);
 }
 
 err_t hash_table_get_load_factor(hash_table *ht,
@@ -289,11 +534,12 @@ err_t hash_table_get_load_factor(hash_table *ht,
         return DEREFERENCING_NULL_PTR;
     }
 
-    if (ht->capacity == 0) {
-        return ZERO_DIVISION;
+    if (ht->current.capacity == 0) {  // nothing allocated yet
+        *load_factor_placeholder = 0;
+        return EXIT_SUCCESS;
     }
 
-    *load_factor_placeholder = (double)ht->size / (double)ht->capacity;
+    *load_factor_placeholder = (double)ht->size / (double)ht->current.capacity;
 
     return EXIT_SUCCESS;
 }
@@ -304,16 +550,30 @@ err_t hash_table_get_chain_length_factor(
         return DEREFERENCING_NULL_PTR;
     }
 
-    if (ht->min_chain_length == 0) {
-        *chain_length_factor_placeholder = 1;
-        return EXIT_SUCCESS;
-    }
-    *chain_length_factor_placeholder =
-        (double)ht->max_chain_length / (double)ht->min_chain_length;
+    // open addressing keeps no chains, every entry is one probe sequence
+    *chain_length_factor_placeholder = 1;
 
     return EXIT_SUCCESS;
 }
 
+size_t wyhash_hash(const void *key, size_t key_size, size_t capacity) {
+    (void)key_size;
+    if (key == NULL || capacity == 0) {
+        return 0;
+    }
+
+    return string_hash(*(const String *)key) % capacity;
+}
+
+size_t id_hash(const void *key, size_t key_size, size_t capacity) {
+    (void)key_size;
+    if (key == NULL || capacity == 0) {
+        return 0;
+    }
+
+    return *(const size_t *)key % capacity;
+}
+
 size_t djb2_to_decimal(const String str) {
     size_t hash = 5381;
     size_t len = string_len(str);
@@ -393,7 +653,7 @@ void sha256_to_string(const String str, unsigned char output[32]) {
 
     size_t len = string_len(str);
     size_t padded_len = ((len + 8) / 64 + 1) * 64;
-    unsigned char *padded = calloc(padded_len, 1);
+    unsigned char *padded = memory_calloc(MEM_HASH_TABLE, padded_len, 1);
     memcpy(padded, str, len);
     padded[len] = 0x80;
 
@@ -462,7 +722,7 @@ void sha256_to_string(const String str, unsigned char output[32]) {
         h[7] += h_var;
     }
 
-    free(padded);
+    memory_free(padded);
 
     for (size_t i = 0; i < 8; i++) {
         output[i * 4] = (h[i] >> 24) & 0xFF;
@@ -1,45 +1,235 @@
+#define _POSIX_C_SOURCE 200809L
 #include "../logger.h"
 
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 
+#include "../memory.h"
+
 #define MAX_LOGGERS 16
+// synchronous messages that fit are written with a single fwrite
+#define LOG_LINE_SIZE (1024)
 
 typedef struct {
     FILE* fp;
     log_level level;
 } Logger;  // loggers instance
 
+/*
+ * Settings are read without locks by every logging thread. Loggers are only
+ * ever appended: a slot is filled before the count that covers it is
+ * published, so a reader sees either the old or the new table. The mutex
+ * only orders writers against each other.
+ */
 static struct {
     log_level level;
     Logger loggers[MAX_LOGGERS];
     size_t loggers_count;
     int log_IO_interaction;
-} L = {LOG_INFO, {{NULL, LOG_INFO}}, 0, 0};
+    pthread_mutex_t lock;
+} L = {LOG_INFO, {{NULL, LOG_INFO}}, 0, 0, PTHREAD_MUTEX_INITIALIZER};
 
 static const char* level_string[] = {"IO",   "TRACE", "DEBUG", "INFO",
                                      "WARN", "ERROR", "FATAL"};
 
+typedef struct {
+    size_t sequence;  // slot is ready to be read when it is position + 1
+    log_level level;
+    int line;
+    const char* file;
+    time_t time;
+    char text[LOG_RECORD_TEXT_SIZE];
+} log_record;
+
+// bounded multi-producer ring, the writer thread is the only consumer
+static struct {
+    log_record* records;
+    size_t mask;
+    size_t head;       // next position claimed by producers
+    size_t tail;       // next position read by the writer
+    size_t written;    // every position below is written and flushed
+    size_t producers;  // log_log calls that may still touch records
+    int running;
+    int stopping;
+    sem_t ready;
+    pthread_t thread;
+} R;
+
+static size_t log_loggers_count(void) {
+    return __atomic_load_n(&L.loggers_count, __ATOMIC_ACQUIRE);
+}
+
+static FILE* log_logger_fp(const Logger* logger) {
+    return __atomic_load_n(&logger->fp, __ATOMIC_RELAXED);
+}
+
+static int log_wants(const Logger* logger, log_level level) {
+    FILE* fp = log_logger_fp(logger);
+
+    return (level >= logger->level) ||
+           ((level == LOG_IO &&
+             __atomic_load_n(&L.log_IO_interaction, __ATOMIC_RELAXED) != 0) &&
+            (fp != stdout) && (fp != stderr));
+}
+
+// cached per thread, so callers and the writer never share it
+static const char* log_time_text(time_t t) {
+    static __thread time_t cached_time = (time_t)-1;
+    static __thread char cached_text[16];
+    struct tm local;
+
+    if (t != cached_time) {
+        localtime_r(&t, &local);
+        strftime(cached_text, sizeof(cached_text), "%H:%M:%S", &local);
+        cached_time = t;
+    }
+    return cached_text;
+}
+
+static void log_prefix(FILE* stream, log_level level, time_t t,
+                       const char* file, int line) {
+    fprintf(stream, "%s %-5s %s:%d: ", log_time_text(t), level_string[level],
+            file, line);  // Prints time and log state
+    if (level == LOG_IO) {
+        fprintf(stream, "\n\n");
+    }
+}
+
+/*
+ * Formats the whole message into a per-thread buffer first: one fwrite holds
+ * the stream lock once, so lines of concurrent threads never interleave and
+ * nobody waits on a logger wide lock. Longer messages keep the stream locked
+ * while they are written piece by piece.
+ */
 static void log_to_stream(FILE* stream, log_level level, const char* file,
                           int line, const char* fmt, va_list ap) {
-    char time_buf[16];
+    static __thread char text[LOG_LINE_SIZE];
     time_t t = time(NULL);
-    strftime(time_buf, sizeof(time_buf), "%H:%M:%S",
-             localtime(&t));  // Format time
-    fprintf(stream, "%s %-5s %s:%d: ", time_buf, level_string[level], file,
-            line);  // Prints time and log state
-    if (level == LOG_IO) {
-        fprintf(stream, "\n\n");
+    size_t length = 0;
+    int written = 0;
+    va_list ap_cpy;
+
+    written = snprintf(text, sizeof(text), "%s %-5s %s:%d: %s",
+                       log_time_text(t), level_string[level], file, line,
+                       level == LOG_IO ? "\n\n" : "");
+    if (written > 0 && (size_t)written < sizeof(text)) {
+        length = (size_t)written;
+        va_copy(ap_cpy, ap);
+        written =
+            vsnprintf(text + length, sizeof(text) - length, fmt, ap_cpy);
+        va_end(ap_cpy);
+        if (written >= 0 && (size_t)written < sizeof(text) - length - 1) {
+            length += (size_t)written;
+            text[length++] = '\n';
+            fwrite(text, 1, length, stream);
+            fflush(stream);
+            return;
+        }
     }
+
+    flockfile(stream);
+    log_prefix(stream, level, t, file, line);
     vfprintf(stream, fmt, ap);  // Print user-defined data
-    fprintf(stream, "\n");
+    fputc('\n', stream);
     fflush(stream);
+    funlockfile(stream);
 }
 
-void log_set_level(log_level level) { L.level = level; }
-void log_set_user_interaction(int enable) { L.log_IO_interaction = enable; }
+static void log_push(log_level level, const char* file, int line,
+                     const char* fmt, va_list ap) {
+    size_t position = __atomic_load_n(&R.head, __ATOMIC_RELAXED);
+    size_t sequence = 0;
+    log_record* record = NULL;
+
+    for (;;) {
+        record = &R.records[position & R.mask];
+        sequence = __atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE);
+        if (sequence == position) {
+            // on failure position is reloaded with the current head
+            if (__atomic_compare_exchange_n(&R.head, &position, position + 1,
+                                            1, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if ((intptr_t)(sequence - position) < 0) {
+            sched_yield();  // full, the writer has not freed this slot yet
+            position = __atomic_load_n(&R.head, __ATOMIC_RELAXED);
+        } else {
+            position = __atomic_load_n(&R.head, __ATOMIC_RELAXED);
+        }
+    }
+
+    record->level = level;
+    record->file = file;
+    record->line = line;
+    record->time = time(NULL);
+    vsnprintf(record->text, sizeof(record->text), fmt, ap);
+    __atomic_store_n(&record->sequence, position + 1, __ATOMIC_RELEASE);
+    sem_post(&R.ready);
+}
+
+static void log_drain(void) {
+    log_record* record = NULL;
+    size_t i = 0, count = 0, loggers_count = log_loggers_count();
+    FILE* fp = NULL;
+
+    for (;;) {
+        record = &R.records[R.tail & R.mask];
+        if (__atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE) !=
+            R.tail + 1) {
+            break;
+        }
+        for (i = 0; i < loggers_count; ++i) {
+            if (log_wants(&L.loggers[i], record->level)) {
+                fp = log_logger_fp(&L.loggers[i]);
+                log_prefix(fp, record->level, record->time, record->file,
+                           record->line);
+                fputs(record->text, fp);
+                fputc('\n', fp);
+            }
+        }
+        // hand the slot back to producers for the next lap
+        __atomic_store_n(&record->sequence, R.tail + R.mask + 1,
+                         __ATOMIC_RELEASE);
+        R.tail++;
+        count++;
+    }
+
+    if (count != 0) {
+        for (i = 0; i < loggers_count; ++i) {
+            fflush(log_logger_fp(&L.loggers[i]));
+        }
+    }
+    __atomic_store_n(&R.written, R.tail, __ATOMIC_RELEASE);
+}
+
+static void* log_writer(void* arg) {
+    (void)arg;
+    int stopping = 0;
+
+    while (!stopping) {
+        if (sem_wait(&R.ready) != 0 && errno == EINTR) {
+            continue;
+        }
+        stopping = __atomic_load_n(&R.stopping, __ATOMIC_ACQUIRE);
+        log_drain();
+    }
+    return NULL;
+}
+
+void log_set_level(log_level level) {
+    __atomic_store_n(&L.level, level, __ATOMIC_RELAXED);
+}
+void log_set_user_interaction(int enable) {
+    __atomic_store_n(&L.log_IO_interaction, enable, __ATOMIC_RELAXED);
+}
 
 err_t log_add_fp(FILE* fp, log_level level) {
     if (fp == NULL) {
@@ -50,72 +240,91 @@ err_t log_add_fp(FILE* fp, log_level level) {
         return DEREFERENCING_NULL_PTR;
     }
 
+    pthread_mutex_lock(&L.lock);
     if (L.loggers_count >= MAX_LOGGERS) {
+        pthread_mutex_unlock(&L.lock);
         fprintf(stderr,
                 "Error: Reached max logger count. "
                 "Aborting adding new logger.\n");
         return ERROR_MAX_LOGGER_COUNT_REACHED;
     }
 
-    L.loggers[L.loggers_count++] = (Logger){fp, level};
+    L.loggers[L.loggers_count] = (Logger){fp, level};
+    __atomic_store_n(&L.loggers_count, L.loggers_count + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&L.lock);
     return EXIT_SUCCESS;
 }
 
-void log_log(log_level level, const char* file, int line, const char* fmt,
-             ...) {
-    if (fmt == NULL) {
-        fprintf(stderr, "Warning: fmt passed to log is NULL.\n");
-        return;
-    }
-
-    if (level < L.level && level != LOG_IO) {
-        return;  // Skip logs below the global level
+err_t log_replace_fp(FILE* from, FILE* to) {
+    if (from == NULL || to == NULL) {
+        fprintf(stderr,
+                "Error: Passed file pointer is NULL. "
+                "Aborting replacing logger.\n");
+        return DEREFERENCING_NULL_PTR;
     }
 
-    va_list ap;
-    va_list ap_cpy;
-    va_start(ap, fmt);
-
-    // Log to all logger instances
+    pthread_mutex_lock(&L.lock);
     for (size_t i = 0; i < L.loggers_count; ++i) {
-        if ((level >= L.loggers[i].level) ||
-            ((level == LOG_IO && L.log_IO_interaction != 0) &&
-             (L.loggers[i].fp != stdout) && (L.loggers[i].fp != stderr))) {
-            va_copy(ap_cpy, ap);
-            log_to_stream(L.loggers[i].fp, level, file, line, fmt, ap_cpy);
-            va_end(ap_cpy);  // Clean up copied va_list
+        if (L.loggers[i].fp == from) {
+            __atomic_store_n(&L.loggers[i].fp, to, __ATOMIC_RELAXED);
         }
     }
+    pthread_mutex_unlock(&L.lock);
+    return EXIT_SUCCESS;
+}
 
+void log_log(log_level level, const char* file, int line, const char* fmt,
+             ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vlog_log(level, file, line, fmt, ap);
     va_end(ap);
 }
 
 void vlog_log(log_level level, const char* file, int line, const char* fmt,
-              va_list ap) {  // copy of prev. function but with va_list ap
-                             // instead of "..." (for logprintf())
+              va_list ap) {
     if (fmt == NULL) {
         fprintf(stderr, "Warning: fmt passed to log is NULL.\n");
         return;
     }
 
-    if (level < L.level && level != LOG_IO) {
+    if (level < __atomic_load_n(&L.level, __ATOMIC_RELAXED) &&
+        level != LOG_IO) {
         return;  // Skip logs below the global level
     }
 
     va_list ap_cpy;
+    size_t i = 0, loggers_count = log_loggers_count();
+    int wanted = 0;
+
+    for (i = 0; i < loggers_count && !wanted; ++i) {
+        wanted = log_wants(&L.loggers[i], level);
+    }
+    if (!wanted) {
+        return;
+    }
+
+    // announced before running is read, so log_stop_async either sees this
+    // producer or this producer sees logging stopped
+    __atomic_add_fetch(&R.producers, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&R.running, __ATOMIC_SEQ_CST)) {
+        va_copy(ap_cpy, ap);
+        log_push(level, file, line, fmt, ap_cpy);
+        va_end(ap_cpy);
+        __atomic_sub_fetch(&R.producers, 1, __ATOMIC_RELEASE);
+        return;
+    }
+    __atomic_sub_fetch(&R.producers, 1, __ATOMIC_RELEASE);
 
     // Log to all logger instances
-    for (size_t i = 0; i < L.loggers_count; ++i) {
-        if ((level >= L.loggers[i].level) ||
-            ((level == LOG_IO && L.log_IO_interaction != 0) &&
-             (L.loggers[i].fp != stdout) && (L.loggers[i].fp != stderr))) {
+    for (i = 0; i < loggers_count; ++i) {
+        if (log_wants(&L.loggers[i], level)) {
             va_copy(ap_cpy, ap);
-            log_to_stream(L.loggers[i].fp, level, file, line, fmt, ap_cpy);
+            log_to_stream(log_logger_fp(&L.loggers[i]), level, file, line, fmt,
+                          ap_cpy);
             va_end(ap_cpy);  // Clean up copied va_list
         }
     }
-
-    va_end(ap);
 }
 
 err_t logger_start() {
@@ -126,3 +335,75 @@ err_t logger_start() {
     }
     return EXIT_SUCCESS;
 }
+
+err_t log_start_async(size_t capacity) {
+    if (__atomic_load_n(&R.running, __ATOMIC_ACQUIRE)) {
+        return EXIT_SUCCESS;
+    }
+
+    size_t i = 0, size = 2;
+
+    while (size < capacity) {
+        size <<= 1;
+    }
+    R.records =
+        (log_record*)memory_alloc(MEM_OTHER, size * sizeof(log_record));
+    if (R.records == NULL) {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    for (i = 0; i < size; ++i) {
+        R.records[i].sequence = i;
+    }
+    R.mask = size - 1;
+    R.head = 0;
+    R.tail = 0;
+    R.written = 0;
+    R.stopping = 0;
+
+    if (sem_init(&R.ready, 0, 0) != 0) {
+        memory_free(R.records);
+        R.records = NULL;
+        return LOGGER_THREAD_ERROR;
+    }
+    if (pthread_create(&R.thread, NULL, log_writer, NULL) != 0) {
+        sem_destroy(&R.ready);
+        memory_free(R.records);
+        R.records = NULL;
+        return LOGGER_THREAD_ERROR;
+    }
+    __atomic_store_n(&R.running, 1, __ATOMIC_RELEASE);
+
+    return EXIT_SUCCESS;
+}
+
+void log_flush(void) {
+    if (!__atomic_load_n(&R.running, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    size_t target = __atomic_load_n(&R.head, __ATOMIC_ACQUIRE);
+
+    while (__atomic_load_n(&R.written, __ATOMIC_ACQUIRE) < target) {
+        sched_yield();
+    }
+}
+
+void log_stop_async(void) {
+    if (!__atomic_load_n(&R.running, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    __atomic_store_n(&R.running, 0, __ATOMIC_SEQ_CST);
+    // producers that saw running still finish their push, the writer drains
+    // it before the ring is freed
+    while (__atomic_load_n(&R.producers, __ATOMIC_SEQ_CST) != 0) {
+        sched_yield();
+    }
+    __atomic_store_n(&R.stopping, 1, __ATOMIC_RELEASE);
+    sem_post(&R.ready);
+    pthread_join(R.thread, NULL);
+
+    sem_destroy(&R.ready);
+    memory_free(R.records);
+    R.records = NULL;
+}
@@ -1,34 +1,345 @@
+#include "../memory.h"
+
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "../errors.h"
 
 void vilka(char const *restrict _format, ...) {
-  void *arg;
-  va_list valist;
-  va_start(valist, _format);
-  while (*_format) {
-    arg = va_arg(valist, void *);
-    if (*_format == 'f') {
-      free(arg);
-    } else if (*_format == 'c') {
-      fclose((FILE *)arg);
-    }
-    _format++;
-  }
-  va_end(valist);
-  return;
+    void *arg;
+    va_list valist;
+    va_start(valist, _format);
+    while (*_format) {
+        arg = va_arg(valist, void *);
+        if (*_format == 'f') {
+            free(arg);
+        } else if (*_format == 'c') {
+            fclose((FILE *)arg);
+        }
+        _format++;
+    }
+    va_end(valist);
+    return;
 }
 
 int rerealloc(void **ptr, size_t size) {
-  void *for_realloc = NULL;
-  int err;
-
-  for_realloc = realloc(*ptr, size);
-  if (for_realloc == NULL) {
-    return MEMORY_ALLOCATION_ERROR;
-  }
-  *ptr = for_realloc;
-  return 0;
+    void *for_realloc = NULL;
+
+    for_realloc = realloc(*ptr, size);
+    if (for_realloc == NULL) {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    *ptr = for_realloc;
+    return 0;
+}
+
+typedef union {
+    struct {
+        size_t size;
+        memory_subsystem subsystem;
+    } info;
+    long double align;  // keeps blocks aligned the way malloc does
+} memory_header;
+
+// last one is the total of all subsystems, updated with relaxed atomics since
+// threads allocate concurrently
+static memory_counters memory_stats[MEM_SUBSYSTEMS_COUNT + 1];
+
+static const char *memory_subsystem_names[] = {
+    "other", "string", "list", "stack", "hash_table", "arena"};
+
+static void memory_account(memory_counters *c, size_t old_size,
+                           size_t new_size) {
+    // unsigned wrap makes adding the difference work for shrinking too
+    size_t live = __atomic_add_fetch(&c->live_bytes, new_size - old_size,
+                                     __ATOMIC_RELAXED);
+    size_t peak = __atomic_load_n(&c->peak_live_bytes, __ATOMIC_RELAXED);
+
+    // on failure peak is reloaded with the current value
+    while (live > peak &&
+           !__atomic_compare_exchange_n(&c->peak_live_bytes, &peak, live, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static void memory_track(memory_subsystem subsystem, size_t old_size,
+                         size_t new_size, int is_realloc) {
+    memory_counters *counters[2];
+    size_t i = 0;
+
+    counters[0] = &memory_stats[subsystem];
+    counters[1] = &memory_stats[MEM_SUBSYSTEMS_COUNT];
+    for (i = 0; i < 2; ++i) {
+        if (is_realloc) {
+            __atomic_fetch_add(&counters[i]->reallocations, 1,
+                               __ATOMIC_RELAXED);
+        } else {
+            __atomic_fetch_add(&counters[i]->allocations, 1, __ATOMIC_RELAXED);
+        }
+        __atomic_fetch_add(&counters[i]->bytes, new_size, __ATOMIC_RELAXED);
+        memory_account(counters[i], old_size, new_size);
+    }
+}
+
+void *memory_alloc(memory_subsystem subsystem, size_t size) {
+    memory_header *header = NULL;
+
+    header = (memory_header *)malloc(sizeof(memory_header) + size);
+    if (header == NULL) {
+        return NULL;
+    }
+    header->info.size = size;
+    header->info.subsystem = subsystem;
+    memory_track(subsystem, 0, size, 0);
+
+    return header + 1;
+}
+
+void *memory_calloc(memory_subsystem subsystem, size_t count, size_t size) {
+    void *ptr = NULL;
+
+    if (size != 0 && count > ((size_t)-1 - sizeof(memory_header)) / size) {
+        return NULL;
+    }
+    ptr = memory_alloc(subsystem, count * size);
+    if (ptr != NULL) {
+        memset(ptr, 0, count * size);
+    }
+
+    return ptr;
+}
+
+void *memory_realloc(memory_subsystem subsystem, void *ptr, size_t size) {
+    memory_header *header = NULL;
+    size_t old_size = 0;
+
+    if (ptr == NULL) {
+        return memory_alloc(subsystem, size);
+    }
+
+    header = (memory_header *)ptr - 1;
+    old_size = header->info.size;
+    subsystem = header->info.subsystem;
+    header = (memory_header *)realloc(header, sizeof(memory_header) + size);
+    if (header == NULL) {
+        return NULL;
+    }
+    header->info.size = size;
+    memory_track(subsystem, old_size, size, 1);
+
+    return header + 1;
+}
+
+void memory_free(void *ptr) {
+    memory_header *header = NULL;
+    memory_counters *c = NULL;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    header = (memory_header *)ptr - 1;
+    c = &memory_stats[header->info.subsystem];
+    __atomic_fetch_add(&c->frees, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&c->live_bytes, header->info.size, __ATOMIC_RELAXED);
+    c = &memory_stats[MEM_SUBSYSTEMS_COUNT];
+    __atomic_fetch_add(&c->frees, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&c->live_bytes, header->info.size, __ATOMIC_RELAXED);
+
+    free(header);
+}
+
+const char *memory_subsystem_name(memory_subsystem subsystem) {
+    if (subsystem >= MEM_SUBSYSTEMS_COUNT) {
+        return "total";
+    }
+    return memory_subsystem_names[subsystem];
+}
+
+void memory_get_counters(memory_subsystem subsystem,
+                         memory_counters *counters) {
+    if (counters == NULL) {
+        return;
+    }
+    if (subsystem > MEM_SUBSYSTEMS_COUNT) {
+        subsystem = MEM_SUBSYSTEMS_COUNT;
+    }
+    const memory_counters *c = &memory_stats[subsystem];
+
+    counters->allocations = __atomic_load_n(&c->allocations, __ATOMIC_RELAXED);
+    counters->reallocations =
+        __atomic_load_n(&c->reallocations, __ATOMIC_RELAXED);
+    counters->frees = __atomic_load_n(&c->frees, __ATOMIC_RELAXED);
+    counters->bytes = __atomic_load_n(&c->bytes, __ATOMIC_RELAXED);
+    counters->live_bytes = __atomic_load_n(&c->live_bytes, __ATOMIC_RELAXED);
+    counters->peak_live_bytes =
+        __atomic_load_n(&c->peak_live_bytes, __ATOMIC_RELAXED);
+}
+
+void memory_reset_peaks(void) {
+    size_t i = 0;
+
+    for (i = 0; i <= MEM_SUBSYSTEMS_COUNT; ++i) {
+        __atomic_store_n(
+            &memory_stats[i].peak_live_bytes,
+            __atomic_load_n(&memory_stats[i].live_bytes, __ATOMIC_RELAXED),
+            __ATOMIC_RELAXED);
+    }
+}
+
+// allocations keep the same alignment as memory_alloc() blocks
+#define MEMORY_ARENA_ALIGN (sizeof(memory_header))
+
+static size_t memory_arena_round_up(size_t size) {
+    return (size + MEMORY_ARENA_ALIGN - 1) / MEMORY_ARENA_ALIGN *
+           MEMORY_ARENA_ALIGN;
+}
+
+static unsigned char *memory_arena_data(memory_arena_block *block) {
+    return (unsigned char *)block +
+           memory_arena_round_up(sizeof(memory_arena_block));
+}
+
+static memory_arena_block *memory_arena_new_block(size_t capacity) {
+    memory_arena_block *block = (memory_arena_block *)memory_alloc(
+        MEM_ARENA, memory_arena_round_up(sizeof(memory_arena_block)) +
+                       capacity);
+    if (block == NULL) {
+        return NULL;
+    }
+    block->next = NULL;
+    block->capacity = capacity;
+    block->used = 0;
+
+    return block;
+}
+
+int memory_arena_init(memory_arena **arena, size_t block_size) {
+    if (arena == NULL) {
+        return DEREFERENCING_NULL_PTR;
+    }
+    if (block_size == 0) {
+        return ZERO_MEMORY_ALLOCATION;
+    }
+
+    memory_arena *a = (memory_arena *)memory_alloc(MEM_ARENA,
+                                                   sizeof(memory_arena));
+    if (a == NULL) {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    a->block_size = memory_arena_round_up(block_size);
+    a->first = memory_arena_new_block(a->block_size);
+    if (a->first == NULL) {
+        memory_free(a);
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    a->current = a->first;
+
+    *arena = a;
+
+    return EXIT_SUCCESS;
+}
+
+void memory_arena_free(memory_arena *arena) {
+    if (arena == NULL) {
+        return;
+    }
+
+    memory_arena_block *block = arena->first, *next = NULL;
+
+    while (block != NULL) {
+        next = block->next;
+        memory_free(block);
+        block = next;
+    }
+    memory_free(arena);
+}
+
+void *memory_arena_alloc(memory_arena *arena, size_t size) {
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    memory_arena_block *block = arena->current, *fresh = NULL;
+    void *ptr = NULL;
+
+    size = memory_arena_round_up(size == 0 ? 1 : size);
+    if (block->capacity - block->used < size) {
+        // blocks after current are left from before a reset or rewind
+        if (block->next != NULL && block->next->capacity >= size) {
+            block = block->next;
+            block->used = 0;
+        } else {
+            fresh = memory_arena_new_block(
+                size > arena->block_size ? size : arena->block_size);
+            if (fresh == NULL) {
+                return NULL;
+            }
+            fresh->next = block->next;
+            block->next = fresh;
+            block = fresh;
+        }
+        arena->current = block;
+    }
+
+    ptr = memory_arena_data(block) + block->used;
+    block->used += size;
+
+    return ptr;
+}
+
+void *memory_arena_realloc(memory_arena *arena, void *ptr, size_t old_size,
+                           size_t new_size) {
+    if (arena == NULL) {
+        return NULL;
+    }
+    if (ptr == NULL) {
+        return memory_arena_alloc(arena, new_size);
+    }
+
+    memory_arena_block *block = arena->current;
+    unsigned char *data = memory_arena_data(block);
+    size_t old_rounded = memory_arena_round_up(old_size == 0 ? 1 : old_size);
+    size_t new_rounded = memory_arena_round_up(new_size == 0 ? 1 : new_size);
+    void *fresh = NULL;
+
+    if ((unsigned char *)ptr + old_rounded == data + block->used &&
+        (size_t)((unsigned char *)ptr - data) + new_rounded <=
+            block->capacity) {
+        block->used = (size_t)((unsigned char *)ptr - data) + new_rounded;
+        return ptr;
+    }
+    if (new_size <= old_size) {
+        return ptr;
+    }
+
+    fresh = memory_arena_alloc(arena, new_size);
+    if (fresh == NULL) {
+        return NULL;
+    }
+    memcpy(fresh, ptr, old_size);
+
+    return fresh;
+}
+
+void memory_arena_reset(memory_arena *arena) {
+    if (arena == NULL) {
+        return;
+    }
+    arena->current = arena->first;
+    arena->first->used = 0;
+}
+
+memory_arena_mark memory_arena_get_mark(const memory_arena *arena) {
+    memory_arena_mark mark = {arena->current, arena->current->used};
+    return mark;
+}
+
+void memory_arena_rewind(memory_arena *arena, memory_arena_mark mark) {
+    if (arena == NULL || mark.block == NULL) {
+        return;
+    }
+    arena->current = mark.block;
+    arena->current->used = mark.used;
 }
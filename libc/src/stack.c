@@ -2,7 +2,13 @@
 /* NULL pointers are not handling bc u_list functional handle them already */
 
 err_t stack_init(stack **s, size_t elem_size, void (*elem_destructor)(void *)) {
-    return u_list_init(s, elem_size, elem_destructor);
+    return u_list_init_accounted(s, elem_size, elem_destructor, MEM_STACK);
+}
+
+err_t stack_init_in_arena(stack **s, size_t elem_size,
+                          void (*elem_destructor)(void *),
+                          memory_arena *arena) {
+    return u_list_init_in_arena(s, elem_size, elem_destructor, arena);
 }
 
 void stack_free(stack *s) { u_list_free(s); }
@@ -1,11 +1,40 @@
+#include "../types.h"
+
 #include <ctype.h>
+#include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "../cstring.h"
 #include "../custom_math.h"
 #include "../errors.h"
 
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define TYPES_SWAR_ENABLED (1)
+#else
+#define TYPES_SWAR_ENABLED (0)
+#endif
+
+#define TYPES_SWAR_ONES (0x0101010101010101ULL)
+
+// non-zero when all 8 bytes (first char in the low byte) are '0'..'9'
+static int types_swar_all_digits(uint64_t chunk) {
+    return ((chunk & (0xF0 * TYPES_SWAR_ONES)) == 0x30 * TYPES_SWAR_ONES) &&
+           (((chunk + 0x06 * TYPES_SWAR_ONES) & (0xF0 * TYPES_SWAR_ONES)) ==
+            0x30 * TYPES_SWAR_ONES);
+}
+
+// value of 8 digits: pairs, then quads, then the whole word
+static uint32_t types_swar_digits_value(uint64_t chunk) {
+    chunk -= 0x30 * TYPES_SWAR_ONES;
+    chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FFULL;
+    chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFFULL;
+    chunk = chunk * 10000 + (chunk >> 32);
+    return (uint32_t)chunk;
+}
+
 int citoa(int num, int base, char **ans) {
     int digit, len, is_negative = 0;
 
@@ -161,6 +190,55 @@ int int_to_char(char *ans, int num) {
     return OK;
 }
 
+// checks the rest of an overflowed number, a non-digit takes precedence
+static int types_overflow_or_invalid(const char *str, size_t length,
+                                     size_t from) {
+    for (; from < length; ++from) {
+        if (str[from] < '0' || str[from] > '9') {
+            return INVALID_NUMBER;
+        }
+    }
+    return NUMBER_OVERFLOW;
+}
+
+// unsigned magnitude up to limit, which is at most INT_MAX + 1
+static int types_parse_decimal(const char *str, size_t length, uint64_t limit,
+                               uint64_t *ans) {
+    uint64_t value = 0, chunk = 0;
+    size_t i = 0;
+
+    if (length == 0) {
+        return INVALID_NUMBER;
+    }
+
+    // value stays below limit before every step, so it can't wrap
+    for (; TYPES_SWAR_ENABLED && i + TYPES_SWAR_DIGITS <= length;
+         i += TYPES_SWAR_DIGITS) {
+        memcpy(&chunk, str + i, sizeof(chunk));
+        if (!types_swar_all_digits(chunk)) {
+            return INVALID_NUMBER;
+        }
+        value = value * 100000000 + types_swar_digits_value(chunk);
+        if (value > limit) {
+            return types_overflow_or_invalid(str, length,
+                                             i + TYPES_SWAR_DIGITS);
+        }
+    }
+    for (; i < length; ++i) {
+        if (str[i] < '0' || str[i] > '9') {
+            return INVALID_NUMBER;
+        }
+        value = value * 10 + (uint64_t)(str[i] - '0');
+        if (value > limit) {
+            return types_overflow_or_invalid(str, length, i + 1);
+        }
+    }
+
+    *ans = value;
+
+    return OK;
+}
+
 int catoi_s(const String str, int base, int *ans) {
     int num = 0;
     int digit = 0;
@@ -174,10 +252,21 @@ int catoi_s(const String str, int base, int *ans) {
 
     len = string_len(str);
 
-    if (str[0] == '-') {
+    if (len > 0 && str[0] == '-') {
         minus = 1;
         index++;
     }
+    if (base == 10) {
+        // magnitude of INT_MIN is one past INT_MAX
+        uint64_t magnitude = 0;
+        int err = types_parse_decimal(str + index, len - index,
+                                      (uint64_t)INT_MAX + minus, &magnitude);
+        if (err) {
+            return err == INVALID_NUMBER ? INVALID_INPUT_DATA : err;
+        }
+        *ans = minus ? (int)(-(int64_t)magnitude) : (int)magnitude;
+        return OK;
+    }
 
     for (; index < len; index++) {
         if (isalpha(str[index])) {
@@ -195,3 +284,71 @@ int catoi_s(const String str, int base, int *ans) {
 
     return OK;
 }
+
+int parse_decimal_int(const char *str, size_t length, int *ans) {
+    uint64_t value = 0;
+
+    if (str == NULL || ans == NULL) {
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    int err = types_parse_decimal(str, length, INT_MAX, &value);
+    if (err) {
+        return err;
+    }
+    *ans = (int)value;
+
+    return OK;
+}
+
+static const char types_digit_pairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static size_t types_digits_count(uint64_t value) {
+    size_t count = 1;
+
+    while (value >= 10000) {
+        value /= 10000;
+        count += 4;
+    }
+    if (value >= 1000) {
+        return count + 3;
+    }
+    if (value >= 100) {
+        return count + 2;
+    }
+    return value >= 10 ? count + 1 : count;
+}
+
+size_t format_uint64(uint64_t value, char *buffer) {
+    size_t length = types_digits_count(value), pair = 0;
+    char *end = buffer + length;
+
+    while (value >= 100) {
+        pair = (size_t)(value % 100) * 2;
+        value /= 100;
+        *--end = types_digit_pairs[pair + 1];
+        *--end = types_digit_pairs[pair];
+    }
+    if (value >= 10) {
+        *--end = types_digit_pairs[value * 2 + 1];
+        *--end = types_digit_pairs[value * 2];
+    } else {
+        *--end = (char)('0' + value);
+    }
+
+    return length;
+}
+
+size_t format_int(int value, char *buffer) {
+    if (value >= 0) {
+        return format_uint64((uint64_t)value, buffer);
+    }
+    *buffer = '-';
+    // negating in unsigned arithmetic keeps INT_MIN right
+    return 1 + format_uint64((uint64_t)0 - (uint64_t)value, buffer + 1);
+}
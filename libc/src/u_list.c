@@ -4,38 +4,138 @@
 #include <stdlib.h>
 #include <string.h>
 
+#define U_LIST_ALIGNMENT (sizeof(void *))
+
+static void u_list_setup(u_list *l, size_t elem_size,
+                         void (*elem_destructor)(void *)) {
+    l->first = NULL;
+    l->last = NULL;
+    l->size = 0;
+    l->elem_destructor = elem_destructor;
+    l->elem_size = elem_size;
+    l->node_size = (sizeof(u_list_node) + elem_size + U_LIST_ALIGNMENT - 1) /
+                   U_LIST_ALIGNMENT * U_LIST_ALIGNMENT;
+    l->slabs = NULL;
+    l->free_nodes = NULL;
+}
+
 err_t u_list_init(u_list **l, size_t elem_size,
                   void (*elem_destructor)(void *)) {
-    if (l == NULL || elem_destructor == NULL) {
+    return u_list_init_accounted(l, elem_size, elem_destructor, MEM_LIST);
+}
+
+err_t u_list_init_accounted(u_list **l, size_t elem_size,
+                            void (*elem_destructor)(void *),
+                            memory_subsystem subsystem) {
+    if (l == NULL) {
         return DEREFERENCING_NULL_PTR;
     }
-    *l = (u_list *)malloc(sizeof(u_list));
+    *l = (u_list *)memory_alloc(subsystem, sizeof(u_list));
     if (*l == NULL) {
         return MEMORY_ALLOCATION_ERROR;
     }
 
-    (*l)->first = NULL;
-    (*l)->last = NULL;
-    (*l)->size = 0;
-    (*l)->elem_destructor = elem_destructor;
-    (*l)->elem_size = elem_size;
+    u_list_setup(*l, elem_size, elem_destructor);
+    (*l)->subsystem = subsystem;
+    (*l)->arena = NULL;
 
     return EXIT_SUCCESS;
 }
 
+err_t u_list_init_in_arena(u_list **l, size_t elem_size,
+                           void (*elem_destructor)(void *),
+                           memory_arena *arena) {
+    if (l == NULL || arena == NULL) {
+        return DEREFERENCING_NULL_PTR;
+    }
+    *l = (u_list *)memory_arena_alloc(arena, sizeof(u_list));
+    if (*l == NULL) {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    u_list_setup(*l, elem_size, elem_destructor);
+    (*l)->subsystem = MEM_ARENA;
+    (*l)->arena = arena;
+
+    return EXIT_SUCCESS;
+}
+
+static void *u_list_alloc(u_list *l, size_t size) {
+    if (l->arena != NULL) {
+        return memory_arena_alloc(l->arena, size);
+    }
+    return memory_alloc(l->subsystem, size);
+}
+
+// arena storage goes away with the arena
+static void u_list_release(u_list *l, void *ptr) {
+    if (l->arena == NULL) {
+        memory_free(ptr);
+    }
+}
+
+// node holding a copy of data: a reused one, the next of the newest slab
+// or the first of a new slab
+static u_list_node *u_list_new_node(u_list *l, const void *data) {
+    u_list_node *node = NULL;
+    u_list_slab *slab = l->slabs;
+    size_t capacity = U_LIST_SLAB_BASE_NODES;
+
+    if (l->free_nodes != NULL) {
+        node = l->free_nodes;
+        l->free_nodes = node->next;
+    } else {
+        if (slab == NULL || slab->used == slab->capacity) {
+            if (slab != NULL) {
+                capacity = slab->capacity * 2 > U_LIST_SLAB_MAX_NODES
+                               ? U_LIST_SLAB_MAX_NODES
+                               : slab->capacity * 2;
+            }
+            slab = (u_list_slab *)u_list_alloc(
+                l, sizeof(u_list_slab) + capacity * l->node_size);
+            if (slab == NULL) {
+                return NULL;
+            }
+            slab->next = l->slabs;
+            slab->capacity = capacity;
+            slab->used = 0;
+            l->slabs = slab;
+        }
+        node = (u_list_node *)((unsigned char *)(slab + 1) +
+                               slab->used++ * l->node_size);
+    }
+    memcpy(node->data, data, l->elem_size);  // deep dark copy
+    node->next = NULL;
+
+    return node;
+}
+
+static void u_list_free_node(u_list *l, u_list_node *node) {
+    if (l->elem_destructor != NULL) {
+        l->elem_destructor(node->data);
+    }
+    node->next = l->free_nodes;
+    l->free_nodes = node;
+}
+
 void u_list_free(u_list *l) {
-    u_list_node *item = NULL, *next = NULL;
+    u_list_node *item = NULL;
+    u_list_slab *slab = NULL, *next = NULL;
     if (l == NULL) {
         return;
     }
-    item = l->first;
-    while (item != NULL) {
-        l->elem_destructor(item->data);
-        next = item->next;
-        free(item);
-        item = next;
+    if (l->elem_destructor != NULL) {
+        for (item = l->first; item != NULL; item = item->next) {
+            l->elem_destructor(item->data);
+        }
+    }
+    slab = l->slabs;
+    while (slab != NULL) {
+        next = slab->next;
+        u_list_release(l, slab);
+        slab = next;
     }
-    free(l);
+    u_list_release(l, l);
     return;
 }
 
@@ -46,21 +146,16 @@ err_t u_list_insert(u_list *l, size_t index, const void *data) {
         return DEREFERENCING_NULL_PTR;
     }
 
-    new = (u_list_node *)malloc(sizeof(u_list_node));
+    new = u_list_new_node(l, data);
     if (new == NULL) {
         return MEMORY_ALLOCATION_ERROR;
     }
-    new->data = malloc(l->elem_size);
-    if (new->data == NULL) {
-        return MEMORY_ALLOCATION_ERROR;
-    }
-    memcpy(new->data, data, l->elem_size);  // deep dark copy
 
     if (index == 0) {
         new->next = l->first;
         l->first = new;
         l->size++;
-        if (l->size == 0) {  // first element also last element
+        if (l->size == 1) {  // first element also last element
             l->last = l->first;
         }
         return EXIT_SUCCESS;
@@ -91,20 +186,11 @@ err_t u_list_push_back(u_list *l, const void *data) {
         return DEREFERENCING_NULL_PTR;
     }
 
-    u_list_node *new_node = (u_list_node *)malloc(sizeof(u_list_node));
+    u_list_node *new_node = u_list_new_node(l, data);
     if (new_node == NULL) {
         return MEMORY_ALLOCATION_ERROR;
     }
 
-    new_node->data = malloc(l->elem_size);
-    if (new_node->data == NULL) {
-        free(new_node);
-        return MEMORY_ALLOCATION_ERROR;
-    }
-
-    memcpy(new_node->data, data, l->elem_size);
-    new_node->next = NULL;
-
     if (l->last == NULL) {
         l->first = new_node;
         l->last = new_node;
@@ -124,19 +210,11 @@ err_t u_list_insert_sorted(u_list *l, const void *data,
         return DEREFERENCING_NULL_PTR;
     }
 
-    u_list_node *new = (u_list_node *)malloc(sizeof(u_list_node));
+    u_list_node *new = u_list_new_node(l, data);
     if (new == NULL) {
         return MEMORY_ALLOCATION_ERROR;
     }
 
-    new->data = malloc(l->elem_size);
-    if (new->data == NULL) {
-        free(new);
-        return MEMORY_ALLOCATION_ERROR;
-    }
-
-    memcpy(new->data, data, l->elem_size);  // deep copy
-
     // Insert at the beginning if the list is empty or the new data is less
     if (l->first == NULL || comp(new->data, l->first->data) <= 0) {
         new->next = l->first;
@@ -220,23 +298,29 @@ err_t u_list_delete_by_index(u_list *l, size_t index) {
     if (index == 0) {
         item = l->first;
         l->first = item->next;
-        l->elem_destructor(item->data);
-        free(item);
+        if (l->last == item) {
+            l->last = NULL;
+        }
+        u_list_free_node(l, item);
         l->size--;
         return EXIT_SUCCESS;
     }
     item = l->first->next;
     father = l->first;
+    i = 1;  // item is the second node
     while (item != NULL) {
         if (i == index) {
             father->next = item->next;
-            l->elem_destructor(item->data);
-            free(item);
+            if (l->last == item) {
+                l->last = father;
+            }
+            u_list_free_node(l, item);
             l->size--;
             return EXIT_SUCCESS;
         }
         father = item;
         item = item->next;
+        i++;
     }
     // too big index
 
@@ -254,8 +338,10 @@ err_t u_list_delete_by_value(u_list *l, const void *target,
     if (l->first != NULL && comp(l->first->data, target) == 0) {
         item = l->first;
         l->first = l->first->next;
-        l->elem_destructor(item->data);
-        free(item);
+        if (l->last == item) {
+            l->last = NULL;
+        }
+        u_list_free_node(l, item);
         l->size--;
         return EXIT_SUCCESS;
     }
@@ -266,8 +352,10 @@ err_t u_list_delete_by_value(u_list *l, const void *target,
         if (comp(item->next->data, target) == 0) {
             u_list_node *temp = item->next;
             item->next = item->next->next;
-            l->elem_destructor(temp->data);
-            free(temp);
+            if (l->last == temp) {
+                l->last = item;
+            }
+            u_list_free_node(l, temp);
             l->size--;
             return EXIT_SUCCESS;
         }
@@ -309,12 +397,6 @@ err_t u_list_traversion(u_list *l, void (*callback)(u_list_node *)) {
     return EXIT_SUCCESS;
 }
 
-void swap_nodes_data(u_list_node *a, u_list_node *b) {
-    void *temp = a->data;
-    a->data = b->data;
-    b->data = temp;
-}
-
 static u_list_node *u_list_split(u_list_node *head) {
     if (!head || !head->next) return head;
 
@@ -1,6 +1,9 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "cstring.h"
 
 int citoa(int num, int base, char **ans);
@@ -9,6 +12,27 @@ int catoi(char const *str, int base, int *ans);
 
 int catoi_s(const String str, int base, int *ans);
 
+#define TYPES_SWAR_DIGITS (8)
+
+/*
+ * Parses length decimal digits (no sign) into ans, checking and converting
+ * 8 digits at a time. INVALID_NUMBER for anything but a digit or an empty
+ * input, NUMBER_OVERFLOW once the value exceeds INT_MAX; ans is not
+ * changed on errors.
+ */
+int parse_decimal_int(const char *str, size_t length, int *ans);
+
+#define TYPES_INT_TEXT_SIZE (11)     // "-2147483648"
+#define TYPES_UINT64_TEXT_SIZE (20)  // "18446744073709551615"
+
+/*
+ * Write decimal text of value to buffer of at least TYPES_*_TEXT_SIZE
+ * bytes, two digits per step from a lookup table. Text is not terminated,
+ * its length is returned.
+ */
+size_t format_uint64(uint64_t value, char *buffer);
+size_t format_int(int value, char *buffer);
+
 int char_to_int(int *ans, char c);
 int int_to_char(char *ans, int num);
 
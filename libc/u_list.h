@@ -4,22 +4,51 @@
 #include <stdlib.h>
 
 #include "errors.h"
+#include "memory.h"
+
+#define U_LIST_SLAB_BASE_NODES (8)
+#define U_LIST_SLAB_MAX_NODES (256)
 
 typedef struct u_list_node {
     struct u_list_node *next;
-    void *data;
+    unsigned char data[];  // element itself, pointer aligned
 } u_list_node;
 
+// block of nodes, slabs of a list double in size up to the max
+typedef struct u_list_slab {
+    struct u_list_slab *next;
+    size_t capacity;
+    size_t used;
+} u_list_slab;
+
 typedef struct u_list {
     u_list_node *first;
     u_list_node *last;  // for queue functional
     size_t size;
     size_t elem_size;
+    size_t node_size;  // node with element, rounded to alignment
     void (*elem_destructor)(void *);
+    u_list_slab *slabs;          // newest first, released by u_list_free
+    u_list_node *free_nodes;     // deleted nodes kept for reuse
+    memory_subsystem subsystem;  // where nodes are accounted
+    memory_arena *arena;         // NULL unless nodes live in an arena
 } u_list;
 
+/*
+ * Elements are copied into their nodes, nodes are taken from slabs owned by
+ * the list. elem_destructor (may be NULL) only disposes of what an element
+ * refers to, the list releases element storage itself.
+ */
 err_t u_list_init(u_list **l, size_t elem_size,
                   void (*elem_destructor)(void *));
+// same, but list and its nodes are accounted to the given subsystem
+err_t u_list_init_accounted(u_list **l, size_t elem_size,
+                            void (*elem_destructor)(void *),
+                            memory_subsystem subsystem);
+// list and nodes are bump allocated, u_list_free only runs destructors
+err_t u_list_init_in_arena(u_list **l, size_t elem_size,
+                           void (*elem_destructor)(void *),
+                           memory_arena *arena);
 void u_list_free(u_list *l);
 
 err_t u_list_insert(u_list *l, size_t index, const void *data);
@@ -0,0 +1,97 @@
+#ifndef VECTOR_H_
+#define VECTOR_H_
+
+#include <stdlib.h>
+
+#include "errors.h"
+#include "memory.h"
+
+#define VECTOR_BASE_CAPACITY (16)
+#define VECTOR_GROWTH_FACTOR (2)
+
+/*
+ * DEFINE_VECTOR(name, type) generates a growable array of type with static
+ * inline functions name_init, name_free, name_reserve, name_push,
+ * name_push_reserved, name_pop and name_top. Elements are stored and
+ * returned by value, so pushes and pops compile down to plain moves. The
+ * struct lives wherever the caller puts it, its array comes from the heap
+ * or from an arena (then name_free does nothing). name_push_reserved
+ * expects room reserved before, name_pop and name_top a non-empty vector.
+ */
+#define DEFINE_VECTOR(name, type)                                              \
+    typedef struct {                                                           \
+        type *data;                                                            \
+        size_t size;                                                           \
+        size_t capacity;                                                       \
+        memory_arena *arena; /* NULL for heap */                               \
+    } name;                                                                    \
+                                                                               \
+    static inline err_t name##_init(name *v, size_t capacity,                  \
+                                    memory_arena *arena) {                     \
+        if (v == NULL) {                                                       \
+            return DEREFERENCING_NULL_PTR;                                     \
+        }                                                                      \
+        v->size = 0;                                                           \
+        v->capacity = capacity == 0 ? VECTOR_BASE_CAPACITY : capacity;        \
+        v->arena = arena;                                                      \
+        if (arena != NULL) {                                                   \
+            v->data = (type *)memory_arena_alloc(arena,                        \
+                                                 v->capacity * sizeof(type));  \
+        } else {                                                               \
+            v->data =                                                          \
+                (type *)memory_alloc(MEM_OTHER, v->capacity * sizeof(type));   \
+        }                                                                      \
+        return v->data == NULL ? MEMORY_ALLOCATION_ERROR : EXIT_SUCCESS;       \
+    }                                                                          \
+                                                                               \
+    static inline void name##_free(name *v) {                                  \
+        if (v != NULL && v->arena == NULL) {                                   \
+            memory_free(v->data);                                              \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    static inline err_t name##_reserve(name *v, size_t capacity) {             \
+        size_t new_capacity = v->capacity;                                     \
+        type *data = NULL;                                                     \
+        if (capacity <= v->capacity) {                                         \
+            return EXIT_SUCCESS;                                               \
+        }                                                                      \
+        while (new_capacity < capacity) {                                      \
+            new_capacity *= VECTOR_GROWTH_FACTOR;                              \
+        }                                                                      \
+        if (v->arena != NULL) {                                                \
+            data = (type *)memory_arena_realloc(v->arena, v->data,             \
+                                                v->capacity * sizeof(type),    \
+                                                new_capacity * sizeof(type));  \
+        } else {                                                               \
+            data = (type *)memory_realloc(MEM_OTHER, v->data,                  \
+                                          new_capacity * sizeof(type));        \
+        }                                                                      \
+        if (data == NULL) {                                                    \
+            return MEMORY_ALLOCATION_ERROR;                                    \
+        }                                                                      \
+        v->data = data;                                                        \
+        v->capacity = new_capacity;                                            \
+        return EXIT_SUCCESS;                                                   \
+    }                                                                          \
+                                                                               \
+    static inline err_t name##_push(name *v, type value) {                     \
+        if (v->size == v->capacity) {                                          \
+            err_t err = name##_reserve(v, v->size + 1);                        \
+            if (err) {                                                         \
+                return err;                                                    \
+            }                                                                  \
+        }                                                                      \
+        v->data[v->size++] = value;                                            \
+        return EXIT_SUCCESS;                                                   \
+    }                                                                          \
+                                                                               \
+    static inline void name##_push_reserved(name *v, type value) {             \
+        v->data[v->size++] = value;                                            \
+    }                                                                          \
+                                                                               \
+    static inline type name##_pop(name *v) { return v->data[--v->size]; }      \
+                                                                               \
+    static inline type *name##_top(name *v) { return v->data + v->size - 1; }
+
+#endif
@@ -9,15 +9,16 @@
 #include "../libc/hash_table.h"
 #include "../libc/logger.h"
 #include "cli.h"
+#include "error_sink.h"
 #include "expression_tree.h"
+#include "output.h"
+#include "parser.h"
 #include "postfix_notation.h"
+#include "stats.h"
 
 void calculate_operators_bucket_free(void *b) {
     hash_table_bucket *bucket = b;
     string_free(*(String *)bucket->key);
-    free(bucket->key);
-    free(bucket->value);
-    free(bucket);
 }
 
 int calculate_operators_keys_compare(const void *a, const void *b) {
@@ -26,18 +27,9 @@ int calculate_operators_keys_compare(const void *a, const void *b) {
     return string_cmp(s1, s2);
 }
 
-void calculate_operands_bucket_free(void *b) {
-    hash_table_bucket *bucket = b;
-    string_free(*(String *)bucket->key);
-    free(bucket->key);
-    free(bucket->value);
-    free(bucket);
-}
-
+// operands are keyed by string_pool ids of variable names
 int calculate_operands_keys_compare(const void *a, const void *b) {
-    String s1 = *(String *)a;
-    String s2 = *(String *)b;
-    return string_cmp(s1, s2);
+    return *(const size_t *)a != *(const size_t *)b;
 }
 
 int calculate_add(int first_arg, ...) {
@@ -112,24 +104,6 @@ int calculate_pow(int first_arg, ...) {
 // Unary Minus
 int calculate_unary_minus(int first_arg, ...) { return -first_arg; }
 
-int calculate_priorities(const String operator) {
-    if (string_cmp_c(operator, "+") == 0 || string_cmp_c(operator, "-") == 0) {
-        return 0;
-    } else if (string_cmp_c(operator, "*") == 0 ||
-               string_cmp_c(operator, "/") == 0 ||
-               string_cmp_c(operator, "%") == 0) {
-        return 1;
-    } else if (string_cmp_c(operator, "~") == 0) {
-        return 2;
-    } else if (string_cmp_c(operator, "^") == 0) {
-        return 3;
-    } else if (string_cmp_c(operator, "(") == 0) {
-        return INT_MIN;
-    } else {
-        return -1;  // Invalid operator
-    }
-}
-
 int calculate_is_operator(const char *op) {
     const char *valid_operators[] = {"+", "-", "*", "/", "%", "~", "^"};
     size_t num_operators = sizeof(valid_operators) / sizeof(valid_operators[0]);
@@ -143,8 +117,47 @@ int calculate_is_operator(const char *op) {
     return 0;
 }
 
-err_t process_calculate_file(file_to_process *file) {
-    if (file == NULL) {
+err_t calculate_init_hash_tables(hash_table **operators,
+                                 hash_table **operands) {
+    if (operators == NULL || operands == NULL) {
+        log_error("passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    err_t err = 0;
+
+    err = hash_table_init_with_hint(
+        operators, calculate_operators_keys_compare, wyhash_hash,
+        sizeof(String *), sizeof(operator_t), calculate_operators_bucket_free,
+        CALCULATE_OPERATORS_COUNT);
+    if (err) {
+        log_error("error while initializing hash table");
+        return err;
+    }
+    err = hash_table_init(operands, calculate_operands_keys_compare, id_hash,
+                          sizeof(size_t), sizeof(int), NULL);
+    if (err) {
+        log_error("error while initializing hash table");
+        hash_table_free(*operators);
+        *operators = NULL;
+        return err;
+    }
+
+    err = calculate_fill_hash_table_with_operators(*operators);
+    if (err) {
+        hash_table_free(*operators);
+        hash_table_free(*operands);
+        *operators = NULL;
+        *operands = NULL;
+        return err;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+err_t process_calculate_file(file_to_process *file,
+                             const output_options *output) {
+    if (file == NULL || output == NULL) {
         log_error("fin ptr is NULL");
         return DEREFERENCING_NULL_PTR;
     }
@@ -152,32 +165,33 @@ err_t process_calculate_file(file_to_process *file) {
     char line[BUFSIZ];
     err_t err = 0;
     size_t len = 0, current_line = 0;
-    FILE *fout = NULL;
-    char error_filename[BUFSIZ];
+    error_sink *errors = NULL;
+    error_sink_buffer errors_buffer;
+    const char *error_description = NULL;
+    output_context context = {output, file->filename, 0};
+    int human = output->format == format_human;
     hash_table *operators = NULL, *operands = NULL;
+    memory_arena *arena = NULL;  // everything of the current line
 
-    err = hash_table_init(&operators, calculate_operators_keys_compare,
-                          djb2_hash, sizeof(String *), sizeof(operator_t),
-                          calculate_operators_bucket_free);
+    err = calculate_init_hash_tables(&operators, &operands);
     if (err) {
-        log_error("error while initializing hash table");
         return err;
     }
-    err = hash_table_init(&operands, calculate_operands_keys_compare, djb2_hash,
-                          sizeof(String *), sizeof(int),
-                          calculate_operands_bucket_free);
+    err = memory_arena_init(&arena, MEMORY_ARENA_BLOCK_SIZE);
     if (err) {
-        log_error("error while initializing hash table");
+        log_error("failed to allocate memory for line arena");
         hash_table_free(operators);
+        hash_table_free(operands);
         return err;
     }
-
-    err = calculate_fill_hash_table_with_operators(operators);
+    err = error_sink_init(&errors, file->filename);
     if (err) {
+        memory_arena_free(arena);
         hash_table_free(operators);
         hash_table_free(operands);
         return err;
     }
+    error_sink_buffer_init(&errors_buffer, errors);
 
     while (fgets(line, sizeof(line), file->data)) {
         len = strlen(line);
@@ -187,159 +201,269 @@ err_t process_calculate_file(file_to_process *file) {
         if (line[0] == '\0') {
             continue;
         }
-        printf("Processing %zu line in %s file: \n\n", current_line,
-               file->filename);
-        err = process_calculate_line(line, operators, operands);
-        if (err != EXIT_SUCCESS && err != INVALID_BRACES &&
-            err != INVALID_SYMBOL && err != INVALID_OPERATIONS) {
-            if (fout != NULL) {
-                fclose(fout);
-            }
+        context.line = current_line;
+        if (human) {
+            printf("Processing %zu line in %s file: \n\n", current_line,
+                   file->filename);
+        }
+        err = process_calculate_line(line, operators, operands, stdout, stdin,
+                                     &context, arena);
+        memory_arena_reset(arena);
+        error_description = cli_error_description(err);
+        if (err != EXIT_SUCCESS && error_description == NULL) {
+            error_sink_flush(&errors_buffer);  // keep what was reported
+            error_sink_free(errors);
+            memory_arena_free(arena);
             hash_table_free(operators);
             hash_table_free(operands);
             return err;
         }
-        if (err == INVALID_BRACES) {
-            if (fout == NULL) {
-                sprintf(error_filename, "%s.errors", file->filename);
-                fout = fopen(error_filename, "w");
-                if (fout == NULL) {
-                    log_error("Error while openning file for errors");
-
-                    hash_table_free(operators);
-                    hash_table_free(operands);
-                    return OPENING_THE_FILE_ERROR;
-                }
+        if (error_description != NULL) {
+            stats_count(stats_errors, 1);
+            err = error_sink_report(&errors_buffer, file->filename,
+                                    current_line, line, error_description);
+            if (err) {
+                error_sink_free(errors);
+                memory_arena_free(arena);
+                hash_table_free(operators);
+                hash_table_free(operands);
+                return err;
             }
-            fprintf(fout, "%s : %zu : [%s] - Invalid braces placement error.\n",
-                    file->filename, current_line, line);
-            printf("Error occured. Skipping...\n\n");
-            current_line++;
-            continue;
-        } else if (err == INVALID_SYMBOL) {
-            if (fout == NULL) {
-                sprintf(error_filename, "%s.errors", file->filename);
-                fout = fopen(error_filename, "w");
-                if (fout == NULL) {
-                    log_error("Error while openning file for errors");
-                    hash_table_free(operators);
-                    hash_table_free(operands);
-                    return OPENING_THE_FILE_ERROR;
-                }
+            if (human) {
+                printf("Error occured. Skipping...\n\n");
+            } else {
+                output_error_record(stdout, &context, error_description);
             }
-            fprintf(fout, "%s : %zu : [%s] - Invalid symbol occurence error.\n",
-                    file->filename, current_line, line);
-            printf("Error occured. Skipping...\n\n");
-            current_line++;
-            continue;
-        } else if (err == INVALID_OPERATIONS) {
-            if (fout == NULL) {
-                sprintf(error_filename, "%s.errors", file->filename);
-                fout = fopen(error_filename, "w");
-                if (fout == NULL) {
-                    log_error("Error while openning file for errors");
-                    hash_table_free(operators);
-                    hash_table_free(operands);
-                    return OPENING_THE_FILE_ERROR;
-                }
-            }
-            fprintf(fout,
-                    "%s : %zu : [%s] - Invalid operations and operands "
-                    "combination.\n",
-                    file->filename, current_line, line);
-            printf("Error occured. Skipping...\n\n");
             current_line++;
             continue;
         }
 
-        printf("Ok.\n\n");
+        if (human) {
+            printf("Ok.\n\n");
+        }
         current_line++;
     }
 
-    if (fout != NULL) {
-        fclose(fout);
-    }
+    err = error_sink_flush(&errors_buffer);
+    error_sink_free(errors);
 
+    memory_arena_free(arena);
     hash_table_free(operators);
     hash_table_free(operands);
 
+    return err;
+}
+
+static err_t calculate_print_human(FILE *out, int res, expression_tree *tree,
+                                   unsigned int emit) {
+    err_t err = 0;
+
+    if (emit & EMIT_RESULT) {
+        fputs("Expression evalutation result: ", out);
+        output_int(out, res);
+        putc('\n', out);
+    }
+
+    if (tree != NULL) {
+        fprintf(out, "Calculation tree: \n\n");
+        fprintf(out, "-----------------\n\n");
+        err = expression_tree_fprint(out, tree);
+        if (err) {
+            return err;
+        }
+        fprintf(out, "\n-----------------\n\n");
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static err_t calculate_print_record(FILE *out, const output_context *context,
+                                    const token_list *postfix, int res,
+                                    expression_tree *tree) {
+    unsigned int emit = context->options->emit;
+    err_t err = 0;
+
+    output_record_begin(out, context);
+    if (emit & EMIT_POSTFIX) {
+        output_record_field(out, context, "postfix");
+        output_postfix(out, context, postfix);
+    }
+    if (emit & EMIT_RESULT) {
+        output_record_field(out, context, "result");
+        output_int(out, res);
+    }
+    if (emit & EMIT_TREE) {
+        output_record_field(out, context, "tree");
+        err = output_tree(out, context, tree);
+        if (err) {
+            return err;
+        }
+    }
+    output_record_end(out, context);
+
     return EXIT_SUCCESS;
 }
 
 err_t process_calculate_line(char *line, hash_table *operators,
-                             hash_table *operands) {
-    if (line == NULL) {
+                             hash_table *operands, FILE *out,
+                             FILE *variables_in,
+                             const output_context *context,
+                             memory_arena *arena) {
+    if (line == NULL || out == NULL || context == NULL) {
         log_error("passed ptr is NULL");
         return DEREFERENCING_NULL_PTR;
     }
 
     err_t err = 0;
-    String infix = NULL, postfix = NULL;
+    token_list *tokens = NULL;
     expression_tree *tree = NULL;
-    int res = 0;
+    int res = 0, *symbol_values = NULL;
+    unsigned int emit = context->options->emit;
+    int human = context->options->format == format_human;
+    uint64_t span = 0;
 
-    infix = string_from(line);
-    if (infix == NULL) {
-        log_error("Failed to allocate memory for infix string");
-        return MEMORY_ALLOCATION_ERROR;
-    }
-    postfix = string_init();
-    if (postfix == NULL) {
-        log_error("Failed to allocate memory for postfix string");
-        string_free(infix);
-        return MEMORY_ALLOCATION_ERROR;
-    }
+    stats_count(stats_lines, 1);
 
-    err = calculate_infix_to_postfix(infix, &postfix);
+    span = stats_span_begin();
+    err = calculate_tokenize(line, operators, arena, &tokens);
     if (err) {
-        string_free(infix);
-        string_free(postfix);
         return err;
     }
+    stats_count(stats_tokens, tokens->size);
 
-    printf("Source: (inf) ");
-    string_print(infix);
-    printf("\nConverted: (post) ");
-    string_print(postfix);
-    printf("\n\n");
-
-    err = calculate_postfix_expression(postfix, &res, operators, operands);
+    // tree is built by the parser, so its time counts as conversion
+    err = parse_tokens(tokens, (emit & EMIT_TREE) ? &tree : NULL);
     if (err) {
-        string_free(infix);
-        string_free(postfix);
+        token_list_free(tokens);
         return err;
     }
+    stats_span_end(stats_conversion, span);
 
-    printf("Expression evalutation result: %d\n", res);
+    if (human && (emit & EMIT_POSTFIX)) {
+        span = stats_span_begin();
+        fprintf(out, "Source: (inf) %s", line);
+        fprintf(out, "\nConverted: (post) ");
+        token_list_fprint(out, tokens);
+        fprintf(out, "\n\n");
+        stats_span_end(stats_output, span);
+    }
 
-    if (string_len(postfix) > 0) {
-        // THIS IS UNSAFE OPERATION. it will segfaults if passed string is
-        // incorrect, calculate_postfix_expression validates string earlier
-        err = expression_tree_fill_with_data_from_postfix_expression(
-            &tree, postfix, operators);
+    if (emit & EMIT_RESULT) {
+        span = stats_span_begin();
+        symbol_values = (int *)token_list_alloc(
+            tokens, (tokens->symbols_count + 1) * sizeof(int));
+        if (symbol_values == NULL) {
+            log_error("Failed to allocate memory for variables values");
+            expression_tree_free(tree);
+            token_list_free(tokens);
+            return MEMORY_ALLOCATION_ERROR;
+        }
+
+        err = calculate_bind_variables(tokens, operands, variables_in,
+                                       human ? stdout : NULL, symbol_values);
         if (err) {
-            string_free(infix);
-            string_free(postfix);
+            token_list_release(tokens, symbol_values);
             expression_tree_free(tree);
+            token_list_free(tokens);
             return err;
         }
-        printf("Calculation tree: \n\n");
-        printf("-----------------\n\n");
-        expression_tree_print(tree);
-        printf("\n-----------------\n\n");
 
-        expression_tree_free(tree);
+        err = calculate_postfix_expression(tokens, symbol_values, arena, &res);
+        token_list_release(tokens, symbol_values);
+        if (err) {
+            expression_tree_free(tree);
+            token_list_free(tokens);
+            return err;
+        }
+        stats_span_end(stats_evaluation, span);
     }
 
-    string_free(infix);
-    string_free(postfix);
+    span = stats_span_begin();
+    if (human) {
+        err = calculate_print_human(out, res, tree, emit);
+    } else {
+        err = calculate_print_record(out, context, tokens, res, tree);
+    }
+    stats_span_end(stats_output, span);
+    expression_tree_free(tree);
+    token_list_free(tokens);
 
-    return EXIT_SUCCESS;
+    return err;
 }
 
-err_t calculate_infix_to_postfix(const String infix_exp, String *postfix_exp) {
-    return infix_to_postfix(infix_exp, isalnum, calculate_is_operator,
-                            calculate_priorities, postfix_exp);
+err_t calculate_tokenize(const char *line, hash_table *operators,
+                         memory_arena *arena, token_list **tokens) {
+    return tokenize(line, isalnum, calculate_is_operator, operators, arena,
+                    tokens);
+}
+
+err_t calculate_bind_variables(const token_list *tokens, hash_table *operands,
+                               FILE *variables_in, FILE *prompt,
+                               int *symbol_values) {
+    if (tokens == NULL || operands == NULL || symbol_values == NULL) {
+        log_error("Passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    size_t i = 0;
+    err_t err = 0;
+    String name = NULL;
+    int *get_from_hash_table = NULL, value = 0, read_count = 0, c = 0;
+
+    for (i = 0; i < tokens->symbols_count; ++i) {
+        name = tokens->symbols[i];
+        stats_count(stats_hash_lookups, 1);
+        err = hash_table_get(operands, &tokens->symbol_ids[i],
+                             (void **)&get_from_hash_table);
+        if (err != EXIT_SUCCESS && err != KEY_NOT_FOUND) {
+            log_error("Error while getting elem from hash table");
+            return err;
+        }
+        if (err == EXIT_SUCCESS) {
+            symbol_values[i] = *get_from_hash_table;
+            continue;
+        }
+        if (variables_in == NULL) {  // nobody to ask
+            log_error("value for variable is unknown");
+            return UNKNOWN_VARIABLE;
+        }
+
+        // variable not found in hash table, asking user for it
+        if (prompt != NULL) {
+            fprintf(prompt, "Please enter value for '");
+            string_fprint(prompt, name);
+            fprintf(prompt, "' variable: ");
+        }
+        while (1) {
+            read_count = fscanf(variables_in, "%d", &value);
+            if (read_count == 1) {
+                break;
+            }
+            if (read_count == EOF) {
+                log_error("input ended, value is unknown");
+                return UNKNOWN_VARIABLE;
+            }
+            if (prompt != NULL) {
+                fprintf(prompt,
+                        "Invalid input. Please enter a valid integer.\n");
+            }
+
+            while ((c = fgetc(variables_in)) != '\n' && c != EOF);
+            if (prompt != NULL) {
+                fprintf(prompt, "Please try again: ");
+            }
+        }
+
+        err = hash_table_set(operands, &tokens->symbol_ids[i], &value);
+        if (err) {
+            log_error("Error push to hash table");
+            return err;
+        }
+
+        symbol_values[i] = value;
+    }
+
+    return EXIT_SUCCESS;
 }
 
 err_t calculate_fill_hash_table_with_operators(hash_table *operators) {
@@ -359,6 +483,7 @@ err_t calculate_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = binary;
+    op->priority = 0;
     representation = string_from("-");
     if (representation == NULL) {
         log_error(
@@ -386,6 +511,7 @@ err_t calculate_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = binary;
+    op->priority = 1;
     representation = string_from("*");
     if (representation == NULL) {
         log_error(
@@ -413,6 +539,7 @@ err_t calculate_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = binary;
+    op->priority = 1;
     representation = string_from("/");
     if (representation == NULL) {
         log_error(
@@ -439,6 +566,7 @@ err_t calculate_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = binary;
+    op->priority = 1;
     representation = string_from("%");
     if (representation == NULL) {
         log_error(
@@ -465,6 +593,7 @@ err_t calculate_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = binary;
+    op->priority = 3;
     representation = string_from("^");
     if (representation == NULL) {
         log_error(
@@ -491,6 +620,7 @@ err_t calculate_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = unary;
+    op->priority = 2;
     representation = string_from("~");
     if (representation == NULL) {
         log_error(
@@ -517,6 +647,7 @@ err_t calculate_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = binary;
+    op->priority = 0;
     representation = string_from("+");
     if (representation == NULL) {
         log_error(
@@ -1,16 +1,41 @@
 #ifndef CALCULATE_H_
 #define CALCULATE_H_
 
+#include <stdio.h>
+
 #include "../libc/cstring.h"
 #include "../libc/errors.h"
 #include "../libc/hash_table.h"
+#include "../libc/memory.h"
 #include "cli.h"
+#include "lexer.h"
+#include "output.h"
+
+#define CALCULATE_OPERATORS_COUNT (7)
 
-err_t process_calculate_file(file_to_process *file);
+err_t process_calculate_file(file_to_process *file,
+                             const output_options *output);
+// writes sections of the line selected by context, skipping work for the
+// ones that are not emitted. Tokens, values and tree are allocated from
+// arena, if it's not NULL, and left there for the caller to reset
 err_t process_calculate_line(char *line, hash_table *operators,
-                             hash_table *operands);
+                             hash_table *operands, FILE *out,
+                             FILE *variables_in,
+                             const output_context *context,
+                             memory_arena *arena);
+
+err_t calculate_init_hash_tables(hash_table **operators,
+                                 hash_table **operands);
+
+err_t calculate_tokenize(const char *line, hash_table *operators,
+                         memory_arena *arena, token_list **tokens);
 
-err_t calculate_infix_to_postfix(const String infix_exp, String *postfix_exp);
+// reads values of tokens symbols from operands, unknown ones are asked from
+// variables_in and stored to operands (NULL gives UNKNOWN_VARIABLE instead),
+// questions are written to prompt unless it's NULL
+err_t calculate_bind_variables(const token_list *tokens, hash_table *operands,
+                               FILE *variables_in, FILE *prompt,
+                               int *symbol_values);
 
 err_t calculate_fill_hash_table_with_operators(hash_table *operators);
 
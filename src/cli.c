@@ -11,23 +11,48 @@ void file_to_process_free(void *f) {
     }
     file_to_process *fp = f;
     fclose(fp->data);
-    free(fp);
 }
 
-err_t parse_cli_arguments(u_list *files, int argc, char *argv[]) {
-    if (files == NULL) {
-        log_error("files ptr is NULL");
+const char *cli_error_description(err_t err) {
+    switch (err) {
+        case INVALID_BRACES:
+            return "Invalid braces placement error.";
+        case INVALID_SYMBOL:
+            return "Invalid symbol occurence error.";
+        case INVALID_OPERATIONS:
+            return "Invalid operations and operands combination.";
+        case INVALID_OPERAND:
+            return "Invalid operand format.";
+        case UNKNOWN_VARIABLE:
+            return "Unknown variable value.";
+        case NUMBER_OVERFLOW:
+            return "Number is too big.";
+        case INVALID_BINDING:
+            return "Invalid variable binding.";
+        default:
+            return NULL;
+    }
+}
+
+err_t parse_cli_arguments(u_list *files, cli_options *options, int argc,
+                          char *argv[]) {
+    if (files == NULL || options == NULL) {
+        log_error("passed ptr is NULL");
         return DEREFERENCING_NULL_PTR;
     }
-    if (files == NULL) {
+    if (argv == NULL) {
         log_error("argv ptr is NULL");
         return DEREFERENCING_NULL_PTR;
     }
 
     err_t err = 0;
-    size_t i = 0;
+    int i = 0;
     file_to_process fp;
 
+    options->serve_path = NULL;
+    options->output = output_default_options;
+    options->stats = 0;
+
     if (argc < 3) {  // at least one file and one flag
         log_error("Not enouth arguments");
         return NOT_ENOUTH_ARGUMENTS;
@@ -62,6 +87,20 @@ err_t parse_cli_arguments(u_list *files, int argc, char *argv[]) {
                 fclose(fp.data);
                 return err;
             }
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            options->serve_path = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            options->stats = 1;
+        } else if (strncmp(argv[i], "--format=", 9) == 0) {
+            err = output_parse_format(argv[i] + 9, &options->output.format);
+            if (err) {
+                return err;
+            }
+        } else if (strncmp(argv[i], "--emit=", 7) == 0) {
+            err = output_parse_emit(argv[i] + 7, &options->output.emit);
+            if (err) {
+                return err;
+            }
         }
     }
 
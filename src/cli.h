@@ -5,6 +5,7 @@
 
 #include "../libc/errors.h"
 #include "../libc/u_list.h"
+#include "output.h"
 
 typedef enum { calculate, table } file_operation;
 
@@ -14,8 +15,19 @@ typedef struct {
     char *filename;
 } file_to_process;
 
-err_t parse_cli_arguments(u_list *files, int argc, char *argv[]);
+typedef struct {
+    char *serve_path;       // NULL unless --serve was passed
+    output_options output;  // --format=jsonl|tsv|human and
+                            // --emit=result,postfix,tree,table
+    int stats;              // --stats, per file stage timings and counters
+} cli_options;
+
+err_t parse_cli_arguments(u_list *files, cli_options *options, int argc,
+                          char *argv[]);
 
 void file_to_process_free(void *f);
 
+// returns NULL if err is not a per-line error that should be skipped
+const char *cli_error_description(err_t err);
+
 #endif  // !CLI_H_
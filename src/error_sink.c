@@ -0,0 +1,182 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "error_sink.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "../libc/logger.h"
+#include "../libc/memory.h"
+#include "../libc/types.h"
+
+#define ERROR_SINK_RECORD_PIECES (7)
+
+err_t error_sink_init(error_sink **sink, const char *filename) {
+    if (sink == NULL || filename == NULL) {
+        log_error("passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    size_t length = strlen(filename);
+    error_sink *s = (error_sink *)memory_alloc(MEM_OTHER, sizeof(error_sink));
+    if (s == NULL) {
+        log_error("failed to allocate memory for error sink");
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    s->path = (char *)memory_alloc(MEM_OTHER, length + sizeof(".errors"));
+    if (s->path == NULL) {
+        log_error("failed to allocate memory for error sink");
+        memory_free(s);
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    memcpy(s->path, filename, length);
+    memcpy(s->path + length, ".errors", sizeof(".errors"));
+    s->fd = -1;
+    s->state = ERROR_SINK_CLOSED;
+
+    *sink = s;
+    return EXIT_SUCCESS;
+}
+
+void error_sink_free(error_sink *sink) {
+    if (sink == NULL) {
+        return;
+    }
+    if (sink->state == ERROR_SINK_OPEN) {
+        close(sink->fd);
+    }
+    memory_free(sink->path);
+    memory_free(sink);
+}
+
+// the first caller creates the file, the others wait until it is there
+static err_t error_sink_open(error_sink *sink) {
+    int state = __atomic_load_n(&sink->state, __ATOMIC_ACQUIRE);
+
+    if (state == ERROR_SINK_CLOSED &&
+        __atomic_compare_exchange_n(&sink->state, &state, ERROR_SINK_OPENING,
+                                    0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        sink->fd = open(sink->path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND,
+                        0644);
+        state = sink->fd < 0 ? ERROR_SINK_FAILED : ERROR_SINK_OPEN;
+        __atomic_store_n(&sink->state, state, __ATOMIC_RELEASE);
+    }
+    while (state == ERROR_SINK_CLOSED || state == ERROR_SINK_OPENING) {
+        sched_yield();
+        state = __atomic_load_n(&sink->state, __ATOMIC_ACQUIRE);
+    }
+
+    if (state == ERROR_SINK_FAILED) {
+        log_error("Error while openning file for errors");
+        return OPENING_THE_FILE_ERROR;
+    }
+    return EXIT_SUCCESS;
+}
+
+// a single writev as long as the kernel takes everything at once
+static err_t error_sink_write(error_sink *sink, struct iovec *pieces,
+                              int count) {
+    err_t err = error_sink_open(sink);
+    ssize_t written = 0;
+
+    if (err) {
+        return err;
+    }
+
+    while (count > 0) {
+        written = writev(sink->fd, pieces, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log_error("failed to write to %s", sink->path);
+            return WRITING_THE_FILE_ERROR;
+        }
+        while (count > 0 && (size_t)written >= pieces->iov_len) {
+            written -= (ssize_t)pieces->iov_len;
+            pieces++;
+            count--;
+        }
+        if (count > 0) {
+            pieces->iov_base = (char *)pieces->iov_base + written;
+            pieces->iov_len -= (size_t)written;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+void error_sink_buffer_init(error_sink_buffer *buffer, error_sink *sink) {
+    buffer->sink = sink;
+    buffer->length = 0;
+}
+
+err_t error_sink_report(error_sink_buffer *buffer, const char *filename,
+                        size_t line, const char *text,
+                        const char *description) {
+    if (buffer == NULL || filename == NULL || text == NULL ||
+        description == NULL) {
+        log_error("passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    char number[TYPES_UINT64_TEXT_SIZE];
+    struct iovec pieces[ERROR_SINK_RECORD_PIECES] = {
+        {(void *)filename, strlen(filename)},
+        {" : ", 3},
+        {number, format_uint64(line, number)},
+        {" : [", 4},
+        {(void *)text, strlen(text)},
+        {"] - ", 4},
+        {(void *)description, strlen(description)},
+    };
+    size_t length = 1;  // trailing newline
+    int i = 0;
+    err_t err = 0;
+
+    for (i = 0; i < ERROR_SINK_RECORD_PIECES; ++i) {
+        length += pieces[i].iov_len;
+    }
+    if (buffer->length + length > ERROR_SINK_BUFFER_SIZE) {
+        err = error_sink_flush(buffer);
+        if (err) {
+            return err;
+        }
+    }
+
+    if (length > ERROR_SINK_BUFFER_SIZE) {
+        struct iovec record[ERROR_SINK_RECORD_PIECES + 1];
+
+        memcpy(record, pieces, sizeof(pieces));
+        record[ERROR_SINK_RECORD_PIECES] = (struct iovec){"\n", 1};
+        return error_sink_write(buffer->sink, record,
+                                ERROR_SINK_RECORD_PIECES + 1);
+    }
+
+    for (i = 0; i < ERROR_SINK_RECORD_PIECES; ++i) {
+        memcpy(buffer->data + buffer->length, pieces[i].iov_base,
+               pieces[i].iov_len);
+        buffer->length += pieces[i].iov_len;
+    }
+    buffer->data[buffer->length++] = '\n';
+    return EXIT_SUCCESS;
+}
+
+err_t error_sink_flush(error_sink_buffer *buffer) {
+    if (buffer == NULL) {
+        log_error("passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
+    }
+    if (buffer->length == 0) {
+        return EXIT_SUCCESS;
+    }
+
+    struct iovec batch = {buffer->data, buffer->length};
+
+    buffer->length = 0;
+    return error_sink_write(buffer->sink, &batch, 1);
+}
@@ -0,0 +1,49 @@
+#ifndef ERROR_SINK_H_
+#define ERROR_SINK_H_
+
+#include <stddef.h>
+
+#include "../libc/errors.h"
+
+#define ERROR_SINK_BUFFER_SIZE (4096)
+
+/*
+ * "<file>.errors" report shared by every worker of an input file:
+ *
+ *     f : 3 : [a + b * (x - y))] - Invalid braces placement error.
+ *
+ * The file is created by the first flush, so input without errors leaves
+ * nothing behind. Workers don't lock anything: each one collects records in
+ * its own error_sink_buffer and a flush hands the whole batch to the kernel
+ * with one append mode write, so records never interleave.
+ */
+typedef struct {
+    char *path;
+    int fd;     // valid once state is ERROR_SINK_OPEN
+    int state;  // ERROR_SINK_* below, changed atomically
+} error_sink;
+
+#define ERROR_SINK_CLOSED (0)
+#define ERROR_SINK_OPENING (1)
+#define ERROR_SINK_OPEN (2)
+#define ERROR_SINK_FAILED (3)
+
+// records of one worker, meant to live on its stack
+typedef struct {
+    error_sink *sink;
+    size_t length;
+    char data[ERROR_SINK_BUFFER_SIZE];
+} error_sink_buffer;
+
+err_t error_sink_init(error_sink **sink, const char *filename);
+// buffers have to be flushed before, unflushed records are lost
+void error_sink_free(error_sink *sink);
+
+void error_sink_buffer_init(error_sink_buffer *buffer, error_sink *sink);
+// flushes on its own once the buffer is full
+err_t error_sink_report(error_sink_buffer *buffer, const char *filename,
+                        size_t line, const char *text,
+                        const char *description);
+err_t error_sink_flush(error_sink_buffer *buffer);
+
+#endif  // !ERROR_SINK_H_
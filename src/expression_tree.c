@@ -1,220 +1,426 @@
 #include "expression_tree.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "../libc/logger.h"
-#include "../libc/stack.h"
-#include "postfix_notation.h"
+#include "../libc/memory.h"
+
+// bytes every node takes in the arrays of the tree, symbol_nodes are sized
+// for the case when every node is a variable
+#define EXPRESSION_TREE_NODE_BYTES                                  \
+    (sizeof(const operator_t *) + 6 * sizeof(uint32_t) + sizeof(int) + \
+     sizeof(unsigned char))
+
+// arrays follow the header from the widest element down, so each one
+// stays aligned, labels go last
+static void expression_tree_layout(expression_tree *t, size_t count,
+                                   size_t symbols_count) {
+    char *next = (char *)(t + 1);
+
+    t->ops = (const operator_t **)next;
+    next += count * sizeof(const operator_t *);
+    t->left = (uint32_t *)next;
+    next += count * sizeof(uint32_t);
+    t->right = (uint32_t *)next;
+    next += count * sizeof(uint32_t);
+    t->parents = (uint32_t *)next;
+    next += count * sizeof(uint32_t);
+    t->symbol_nodes = (uint32_t *)next;
+    next += count * sizeof(uint32_t);
+    t->symbol_starts = (uint32_t *)next;
+    next += (symbols_count + 1) * sizeof(uint32_t);
+    t->label_offsets = (uint32_t *)next;
+    next += count * sizeof(uint32_t);
+    t->label_lengths = (uint32_t *)next;
+    next += count * sizeof(uint32_t);
+    t->values = (int *)next;
+    next += count * sizeof(int);
+    t->kinds = (unsigned char *)next;
+    next += count * sizeof(unsigned char);
+    t->labels = next;
+}
+
+void expression_tree_free(void *tree) {
+    expression_tree *t = tree;
+
+    if (t == NULL || t->arena != NULL) {
+        return;
+    }
+    memory_free(t);
+}
 
-err_t expression_tree_init(expression_tree **t) {
+err_t expression_tree_init(expression_tree **t, size_t capacity,
+                           size_t symbols_count, size_t text,
+                           memory_arena *arena) {
     if (t == NULL) {
         log_error("passed ptr is NULL");
         return DEREFERENCING_NULL_PTR;
     }
 
-    *t = (expression_tree *)malloc(sizeof(expression_tree));
-    if (*t == NULL) {
-        log_error("failed to allocatte memory");
-        return MEMORY_ALLOCATION_ERROR;
+    expression_tree *tree = NULL;
+    size_t bytes = 0;
+
+    *t = NULL;
+    if (capacity >= EXPRESSION_TREE_NO_CHILD || text > UINT32_MAX) {
+        log_error("expression is too long for tree");
+        return INVALID_INPUT_DATA;
+    }
+    bytes = sizeof(expression_tree) + capacity * EXPRESSION_TREE_NODE_BYTES +
+            (symbols_count + 1) * sizeof(uint32_t) + text;
+
+    if (arena != NULL) {
+        tree = (expression_tree *)memory_arena_alloc(arena, bytes);
+    } else {
+        tree = (expression_tree *)memory_alloc(MEM_OTHER, bytes);
     }
-    expression_tree *tree = *t;
-    tree->left = NULL;
-    tree->right = NULL;
-    tree->token = string_init();
-    if (tree->token == NULL) {
-        log_error("failed to allocatte memory");
-        free(tree);
+    if (tree == NULL) {
+        log_error("failed to allocate memory for tree");
         return MEMORY_ALLOCATION_ERROR;
     }
 
+    tree->size = 0;
+    tree->symbols_count = symbols_count;
+    tree->arena = arena;
+    expression_tree_layout(tree, capacity, symbols_count);
+    memset(tree->symbol_starts, 0, (symbols_count + 1) * sizeof(uint32_t));
+
+    *t = tree;
     return EXIT_SUCCESS;
 }
 
-void expression_tree_free(void *tree) {
-    if (tree == NULL) {
-        return;
+void expression_tree_append(expression_tree *t, const token *node,
+                            const char *source, uint32_t left,
+                            uint32_t right) {
+    size_t i = t->size++;
+    uint32_t text = 0;
+
+    if (i > 0) {
+        text = t->label_offsets[i - 1] + t->label_lengths[i - 1];
     }
-    expression_tree_node *t = tree;
 
-    expression_tree_free(t->left);
-    expression_tree_free(t->right);
-    string_free(t->token);
-    free(t);
+    t->kinds[i] = (unsigned char)node->kind;
+    t->ops[i] = node->kind == token_operator ? node->op : NULL;
+    t->left[i] = left;
+    t->right[i] = right;
+    t->parents[i] = EXPRESSION_TREE_NO_CHILD;
+    t->values[i] = 0;
+    t->label_offsets[i] = text;
+    t->label_lengths[i] = (uint32_t)node->length;
+    memcpy(t->labels + text, source + node->offset, node->length);
+
+    if (left != EXPRESSION_TREE_NO_CHILD) {
+        t->parents[left] = (uint32_t)i;
+    }
+    if (right != EXPRESSION_TREE_NO_CHILD) {
+        t->parents[right] = (uint32_t)i;
+    }
+    if (node->kind == token_number) {
+        t->values[i] = node->value;
+    } else if (node->kind == token_variable) {
+        t->values[i] = (int)node->symbol_id;
+        t->symbol_starts[node->symbol_id + 1]++;
+    }
 }
 
-void expression_tree_free_single_node(void *tree) {
-    if (tree == NULL) {
-        return;
+void expression_tree_finish(expression_tree *t) {
+    size_t i = 0;
+
+    // counts become starts, then every start is moved past its nodes while
+    // they are placed and shifted back afterwards
+    for (i = 0; i < t->symbols_count; ++i) {
+        t->symbol_starts[i + 1] += t->symbol_starts[i];
+    }
+    for (i = 0; i < t->size; ++i) {
+        if (t->kinds[i] == token_variable) {
+            t->symbol_nodes[t->symbol_starts[t->values[i]]++] = (uint32_t)i;
+        }
+    }
+    for (i = t->symbols_count; i > 0; --i) {
+        t->symbol_starts[i] = t->symbol_starts[i - 1];
+    }
+    t->symbol_starts[0] = 0;
+}
+
+// children of the node have to be evaluated already
+static inline int expression_tree_node_value(const expression_tree *t,
+                                             size_t i,
+                                             const int *symbol_values,
+                                             const int *node_values) {
+    switch (t->kinds[i]) {
+        case token_number:
+            return t->values[i];
+        case token_variable:
+            return symbol_values[t->values[i]];
+        default:  // operator
+            if (t->ops[i]->type == binary) {
+                return t->ops[i]->func(node_values[t->left[i]],
+                                       node_values[t->right[i]]);
+            }
+            return t->ops[i]->func(node_values[t->left[i]]);
     }
+}
 
-    expression_tree_node *t = tree;
+int expression_tree_evaluate(const expression_tree *t,
+                             const int *symbol_values, int *node_values) {
+    size_t i = 0;
+
+    for (i = 0; i < t->size; ++i) {
+        node_values[i] =
+            expression_tree_node_value(t, i, symbol_values, node_values);
+    }
 
-    string_free(t->token);
-    free(t);
+    return t->size == 0 ? 0 : node_values[t->size - 1];
 }
 
-err_t expression_tree_fill_with_data_from_postfix_expression(
-    expression_tree **t, const String postfix_exp, hash_table *operators) {
-    if (t == NULL || postfix_exp == NULL || operators == NULL) {
-        log_error("Passed ptr is NULL");
+err_t expression_tree_cache_init(expression_tree_cache **c,
+                                 const expression_tree *t,
+                                 const int *symbol_values,
+                                 memory_arena *arena) {
+    if (c == NULL || t == NULL ||
+        (symbol_values == NULL && t->symbols_count > 0)) {
+        log_error("passed ptr is NULL");
         return DEREFERENCING_NULL_PTR;
     }
 
-    size_t i = 0;
-    err_t err = 0;
-    char pe = 0;
-    String token = NULL;
-    stack *st = NULL;
-    operator_t *op = NULL;
-    expression_tree_node *operand_1 = NULL, *operand_2 = NULL;
-    expression_tree_node *node = NULL;
-    stack_item *p_for_stack;
-
-    err = stack_init(&st, sizeof(expression_tree_node *), free);
-    if (err) {
-        log_error("Error during stack initialization");
-        return err;
+    // every node is pending at most once, so arrays are sized by the tree
+    size_t bytes = sizeof(expression_tree_cache) +
+                   t->size * (sizeof(uint32_t) + sizeof(int)) +
+                   t->symbols_count * sizeof(int) + t->size;
+    expression_tree_cache *cache = NULL;
+    char *next = NULL;
+
+    if (arena != NULL) {
+        cache = (expression_tree_cache *)memory_arena_alloc(arena, bytes);
+    } else {
+        cache = (expression_tree_cache *)memory_alloc(MEM_OTHER, bytes);
     }
-
-    token = string_init();
-    if (token == NULL) {
-        log_error("Failed to allocate memory for token");
-        stack_free(st);
+    if (cache == NULL) {
+        log_error("failed to allocate memory for tree cache");
         return MEMORY_ALLOCATION_ERROR;
     }
 
-    for (i = 0; i < string_len(postfix_exp); ++i) {
-        pe = postfix_exp[i];
+    next = (char *)(cache + 1);
+    cache->pending = (uint32_t *)next;
+    next += t->size * sizeof(uint32_t);
+    cache->node_values = (int *)next;
+    next += t->size * sizeof(int);
+    cache->symbol_values = (int *)next;
+    next += t->symbols_count * sizeof(int);
+    cache->dirty = (unsigned char *)next;
+
+    cache->tree = t;
+    cache->pending_count = 0;
+    cache->pending_sorted = 1;
+    cache->arena = arena;
+    if (t->symbols_count > 0) {
+        memcpy(cache->symbol_values, symbol_values,
+               t->symbols_count * sizeof(int));
+    }
+    memset(cache->dirty, 0, t->size);
+    expression_tree_evaluate(t, cache->symbol_values, cache->node_values);
+
+    *c = cache;
+    return EXIT_SUCCESS;
+}
 
-        if (pe == ' ') {
-            if (string_len(token) == 0) {
-                continue;
-            }
+void expression_tree_cache_free(expression_tree_cache *c) {
+    if (c == NULL || c->arena != NULL) {
+        return;
+    }
+    memory_free(c);
+}
 
-            op = NULL;
-            err = hash_table_get(operators, &token, (void **)&op);
-            if (err != EXIT_SUCCESS && err != KEY_NOT_FOUND) {
-                log_error("Error while getting element from hash table");
-                string_free(token);
-                stack_free(st);
-                return err;
-            }
+err_t expression_tree_cache_set(expression_tree_cache *c, size_t symbol_id,
+                                int value) {
+    if (c == NULL) {
+        log_error("passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
+    }
 
-            if (err == KEY_NOT_FOUND) {  // Operand
-                node = (expression_tree_node *)malloc(
-                    sizeof(expression_tree_node));
-                if (node == NULL) {
-                    log_error("Memory allocation error for operand node");
-                    string_free(token);
-                    stack_free(st);
-                    return MEMORY_ALLOCATION_ERROR;
-                }
-                node->token = token;
-                node->left = NULL;
-                node->right = NULL;
-                token = NULL;
-
-                err = stack_push(st, &node);
-                if (err) {
-                    log_error("Error pushing operand to stack");
-                    free(node);
-                    string_free(token);
-                    stack_free(st);
-                    return err;
-                }
-            } else {  // Operator
-                if (op->type == binary) {
-                    stack_top(st, &p_for_stack);
-                    operand_1 = *(expression_tree_node **)p_for_stack->data;
-                    stack_pop(st);
-
-                    stack_top(st, &p_for_stack);
-                    operand_2 = *(expression_tree_node **)p_for_stack->data;
-                    stack_pop(st);
-
-                    node = (expression_tree_node *)malloc(
-                        sizeof(expression_tree_node));
-                    if (node == NULL) {
-                        log_error("Memory allocation error for operator node");
-                        string_free(token);
-                        stack_free(st);
-                        return MEMORY_ALLOCATION_ERROR;
-                    }
-                    node->token = token;
-                    node->left = operand_2;
-                    node->right = operand_1;
-                    token = NULL;
-
-                    err = stack_push(st, &node);
-                    if (err) {
-                        log_error("Error pushing operator node to stack");
-                        free(node);
-                        string_free(token);
-                        stack_free(st);
-                        return err;
-                    }
-                }
-            }
+    const expression_tree *t = c->tree;
+    uint32_t node = 0, i = 0;
 
-            string_free(token);
-            token = string_init();
-            if (token == NULL) {
-                log_error("Failed to allocate memory for token");
-                stack_free(st);
-                return MEMORY_ALLOCATION_ERROR;
-            }
-        } else {
-            // Add character to token
-            err = string_add(&token, pe);
-            if (err) {
-                log_error("Error adding character to token");
-                string_free(token);
-                stack_free(st);
-                return err;
-            }
+    if (symbol_id >= t->symbols_count) {
+        log_error("no symbol with id %zu in the tree", symbol_id);
+        return INDEX_OUT_OF_BOUNDS;
+    }
+    if (c->symbol_values[symbol_id] == value) {
+        return EXIT_SUCCESS;
+    }
+    c->symbol_values[symbol_id] = value;
+
+    // ancestors of a dirty node are dirty already, so a path stops there
+    for (i = t->symbol_starts[symbol_id]; i < t->symbol_starts[symbol_id + 1];
+         ++i) {
+        node = t->symbol_nodes[i];
+        if (!c->dirty[node] && c->pending_count > 0 &&
+            c->pending[c->pending_count - 1] > node) {
+            c->pending_sorted = 0;
+        }
+        while (node != EXPRESSION_TREE_NO_CHILD && !c->dirty[node]) {
+            c->dirty[node] = 1;
+            c->pending[c->pending_count++] = node;
+            node = t->parents[node];
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// pending is a few ascending paths one after another, short and nearly
+// sorted, which insertion sort handles best
+static void expression_tree_sort_pending(uint32_t *pending, size_t count) {
+    size_t i = 0, j = 0;
+    uint32_t node = 0;
+
+    for (i = 1; i < count; ++i) {
+        node = pending[i];
+        for (j = i; j > 0 && pending[j - 1] > node; --j) {
+            pending[j] = pending[j - 1];
         }
+        pending[j] = node;
     }
+}
 
-    stack_top(st, &p_for_stack);
+int expression_tree_cache_result(expression_tree_cache *c) {
+    const expression_tree *t = c->tree;
+    size_t i = 0;
+    uint32_t node = 0;
+
+    // a single path is marked bottom up, several ones need sorting so
+    // children still go before parents
+    if (!c->pending_sorted) {
+        expression_tree_sort_pending(c->pending, c->pending_count);
+    }
+    for (i = 0; i < c->pending_count; ++i) {
+        node = c->pending[i];
+        c->node_values[node] = expression_tree_node_value(
+            t, node, c->symbol_values, c->node_values);
+        c->dirty[node] = 0;
+    }
+    c->pending_count = 0;
+    c->pending_sorted = 1;
 
-    operand_1 = *(expression_tree_node **)p_for_stack->data;
+    return c->node_values[t->size - 1];
+}
 
-    stack_pop(st);
+typedef struct {
+    uint32_t node;
+    size_t depth;
+} expression_tree_render_frame;
+
+// one line of picture: "|    " for every level above, "|-- " and token
+static err_t expression_tree_render_node(String *buffer,
+                                         const expression_tree *t,
+                                         uint32_t node, size_t depth) {
+    static const char level[] = "|    ";
+    static const char branch[] = "|-- ";
+    size_t i = 0, length = t->label_lengths[node];
+    err_t err = 0;
 
-    *t = operand_1;
+    err = string_reserve(buffer, string_len(*buffer) +
+                                     (depth - 1) * (sizeof(level) - 1) +
+                                     (sizeof(branch) - 1) + length + 3);
+    if (err) {
+        return err;
+    }
 
-    string_free(token);
-    stack_free(st);
+    for (i = 1; i < depth; ++i) {
+        string_cat_c(buffer, level);
+    }
+    if (depth > 1) {
+        string_cat_c(buffer, branch);
+    }
+    string_add(buffer, '\'');
+    string_append(buffer, t->labels + t->label_offsets[node], length);
+    string_add(buffer, '\'');
+    string_add(buffer, '\n');
 
     return EXIT_SUCCESS;
 }
 
-void __expression_tree_print_inner(expression_tree_node *t, size_t depth,
-                                   const char *prefix) {
-    if (t == NULL) {
-        return;
+err_t expression_tree_render(expression_tree *t, String *buffer) {
+    if (buffer == NULL || *buffer == NULL) {
+        log_error("passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
     }
 
-    char new_prefix[256];
-    snprintf(new_prefix, sizeof(new_prefix), "%s%s", prefix, "|    ");
+    expression_tree_render_frame *frames = NULL;
+    size_t size = 0, depth = 1;
+    uint32_t current = EXPRESSION_TREE_NO_CHILD;
+    err_t err = 0;
 
-    __expression_tree_print_inner(t->right, depth + 1, new_prefix);
+    if (t == NULL || t->size == 0) {
+        return EXIT_SUCCESS;
+    }
 
-    printf("%s", prefix);
-    if (depth > 1) {
-        printf("|-- ");
+    // path from the root never has more nodes than the tree
+    frames = (expression_tree_render_frame *)memory_alloc(
+        MEM_OTHER, t->size * sizeof(expression_tree_render_frame));
+    if (frames == NULL) {
+        log_error("failed to allocate memory for render stack");
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    // right subtree goes above the node and left one below, so it's
+    // in-order traversal with children swapped, done with explicit stack
+    current = (uint32_t)(t->size - 1);
+    while (current != EXPRESSION_TREE_NO_CHILD || size > 0) {
+        while (current != EXPRESSION_TREE_NO_CHILD) {
+            frames[size].node = current;
+            frames[size].depth = depth;
+            size++;
+            current = t->right[current];
+            depth++;
+        }
+
+        size--;
+        err = expression_tree_render_node(buffer, t, frames[size].node,
+                                          frames[size].depth);
+        if (err) {
+            log_error("failed to render tree node");
+            memory_free(frames);
+            return err;
+        }
+        current = t->left[frames[size].node];
+        depth = frames[size].depth + 1;
     }
-    printf("'");
-    string_print(t->token);
-    printf("'");
-    printf("\n");
 
-    __expression_tree_print_inner(t->left, depth + 1, new_prefix);
+    memory_free(frames);
+    return EXIT_SUCCESS;
 }
 
-void expression_tree_print(expression_tree *t) {
+err_t expression_tree_fprint(FILE *out, expression_tree *t) {
+    if (out == NULL) {
+        log_error("passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    String buffer = NULL;
+    err_t err = 0;
+
     if (t == NULL) {
-        return;
+        return EXIT_SUCCESS;
     }
-    __expression_tree_print_inner(t, 1, "");
+
+    buffer = string_init();
+    if (buffer == NULL) {
+        log_error("failed to allocate memory for tree picture");
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    err = expression_tree_render(t, &buffer);
+    if (err) {
+        string_free(buffer);
+        return err;
+    }
+    fwrite(buffer, sizeof(char), string_len(buffer), out);
+
+    string_free(buffer);
+    return EXIT_SUCCESS;
+}
+
+err_t expression_tree_print(expression_tree *t) {
+    return expression_tree_fprint(stdout, t);
 }
@@ -1,23 +1,98 @@
 #ifndef EXPRESSION_TREE_
 #define EXPRESSION_TREE_
 
+#include <stdint.h>
+#include <stdio.h>
+
 #include "../libc/cstring.h"
 #include "../libc/errors.h"
-#include "../libc/hash_table.h"
+#include "../libc/memory.h"
+#include "lexer.h"
 
-typedef struct expression_tree_node {
-    String token;
-    struct expression_tree_node *left, *right;
-} expression_tree_node;
+// child index of leaves and of the right side of unary operators, parent
+// of the root
+#define EXPRESSION_TREE_NO_CHILD (UINT32_MAX)
 
-typedef expression_tree_node expression_tree;
+/*
+ * Nodes are kept in postfix order as parallel arrays, so children always
+ * come before their parent, the root is the last node and evaluation is one
+ * pass over the arrays. Arrays and labels share a single allocation.
+ */
+typedef struct {
+    size_t size;
+    const operator_t **ops;  // only for operators
+    uint32_t *left;          // unary operators keep operand in left
+    uint32_t *right;
+    uint32_t *parents;
+    // variable nodes of symbol s are symbol_nodes[symbol_starts[s]] up to
+    // symbol_nodes[symbol_starts[s + 1]]
+    size_t symbols_count;
+    uint32_t *symbol_starts;
+    uint32_t *symbol_nodes;
+    int *values;  // literal of numbers, symbol id of variables
+    uint32_t *label_offsets;
+    uint32_t *label_lengths;
+    unsigned char *kinds;  // token_kind of the node
+    char *labels;          // token texts one after another
+    memory_arena *arena;   // where the tree lives, NULL for heap
+} expression_tree;
 
-err_t expression_tree_init(expression_tree **t);
+// does nothing for trees built in arena
 void expression_tree_free(void *t);
 
-err_t expression_tree_fill_with_data_from_postfix_expression(
-    expression_tree **t, const String postfix_exp, hash_table *operators);
+/*
+ * Trees are filled by the parser while it emits postfix, one node per
+ * emitted token, so children are always appended before their parent.
+ * Storage is reserved for capacity nodes with labels of text bytes in
+ * total. Tree made in arena lives until the arena is reset.
+ */
+err_t expression_tree_init(expression_tree **t, size_t capacity,
+                           size_t symbols_count, size_t text,
+                           memory_arena *arena);
+// missing children are EXPRESSION_TREE_NO_CHILD, label is taken from source
+void expression_tree_append(expression_tree *t, const token *node,
+                            const char *source, uint32_t left,
+                            uint32_t right);
+// indexes variable nodes by symbol once every node is appended
+void expression_tree_finish(expression_tree *t);
+
+// node_values has room for every node and gets value of each subtree
+int expression_tree_evaluate(const expression_tree *t,
+                             const int *symbol_values, int *node_values);
+
+/*
+ * Evaluation kept between variable changes, spreadsheet style: rebinding a
+ * variable marks the paths from its nodes up to the root dirty and the next
+ * result recomputes only dirty nodes, children first. A change costs
+ * O(depth) instead of O(size) of a whole evaluation.
+ */
+typedef struct {
+    const expression_tree *tree;
+    int *symbol_values;
+    int *node_values;
+    unsigned char *dirty;
+    uint32_t *pending;  // dirty nodes in order of marking
+    size_t pending_count;
+    int pending_sorted;  // pending is in ascending (postfix) order
+    memory_arena *arena;
+} expression_tree_cache;
+
+// evaluates whole tree once, the tree has to outlive the cache
+err_t expression_tree_cache_init(expression_tree_cache **c,
+                                 const expression_tree *t,
+                                 const int *symbol_values,
+                                 memory_arena *arena);
+// does nothing for caches made in arena
+void expression_tree_cache_free(expression_tree_cache *c);
+
+err_t expression_tree_cache_set(expression_tree_cache *c, size_t symbol_id,
+                                int value);
+int expression_tree_cache_result(expression_tree_cache *c);
+
+// appends picture of the tree to buffer, right subtrees are drawn above
+err_t expression_tree_render(expression_tree *t, String *buffer);
 
-void expression_tree_print(expression_tree *t);
+err_t expression_tree_print(expression_tree *t);
+err_t expression_tree_fprint(FILE *out, expression_tree *t);
 
 #endif  // !EXPRESSION_TREE_
@@ -0,0 +1,339 @@
+#include "lexer.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../libc/hashmap.h"
+#include "../libc/logger.h"
+#include "../libc/memory.h"
+#include "../libc/types.h"
+#include "stats.h"
+
+#define TOKEN_LIST_BASE_CAPACITY (16)
+// lines with fewer distinct symbols find them by scanning symbol_ids
+#define TOKENIZE_LINEAR_SYMBOLS (8)
+
+DEFINE_HASHMAP(symbol_index_map, size_t, size_t, hashmap_id_hash,
+               hashmap_id_equals)
+
+err_t token_list_init(token_list **l, const char *source,
+                      memory_arena *arena) {
+    if (l == NULL || source == NULL) {
+        log_error("passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    token_list *list = NULL;
+
+    if (arena != NULL) {
+        list = (token_list *)memory_arena_alloc(arena, sizeof(token_list));
+    } else {
+        list = (token_list *)malloc(sizeof(token_list));
+    }
+    if (list == NULL) {
+        log_error("failed to allocate memory for token list");
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    list->arena = arena;
+
+    list->tokens = (token *)token_list_alloc(
+        list, TOKEN_LIST_BASE_CAPACITY * sizeof(token));
+    if (list->tokens == NULL) {
+        log_error("failed to allocate memory for tokens");
+        token_list_release(list, list);
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    list->source = source;
+    list->size = 0;
+    list->capacity = TOKEN_LIST_BASE_CAPACITY;
+    list->symbols = NULL;
+    list->symbol_ids = NULL;
+    list->symbols_count = 0;
+    list->symbols_capacity = 0;
+
+    *l = list;
+
+    return EXIT_SUCCESS;
+}
+
+void *token_list_alloc(token_list *l, size_t size) {
+    if (l->arena != NULL) {
+        return memory_arena_alloc(l->arena, size);
+    }
+    return malloc(size);
+}
+
+void token_list_release(token_list *l, void *ptr) {
+    if (l->arena == NULL) {
+        free(ptr);
+    }
+}
+
+static err_t token_list_grow(token_list *l, void **ptr, size_t old_size,
+                             size_t new_size) {
+    void *grown = NULL;
+
+    if (l->arena == NULL) {
+        return rerealloc(ptr, new_size);
+    }
+    grown = memory_arena_realloc(l->arena, *ptr, old_size, new_size);
+    if (grown == NULL) {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    *ptr = grown;
+
+    return EXIT_SUCCESS;
+}
+
+void token_list_free(token_list *l) {
+    if (l == NULL || l->arena != NULL) {
+        return;
+    }
+
+    free(l->symbols);
+    free(l->symbol_ids);
+    free(l->tokens);
+    free(l);
+}
+
+err_t token_list_push(token_list *l, const token *t) {
+    if (l == NULL || t == NULL) {
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    err_t err = 0;
+
+    if (l->size == l->capacity) {
+        err = token_list_grow(l, (void **)&l->tokens,
+                              l->capacity * sizeof(token),
+                              l->capacity * 2 * sizeof(token));
+        if (err) {
+            return err;
+        }
+        l->capacity *= 2;
+    }
+    l->tokens[l->size++] = *t;
+
+    return EXIT_SUCCESS;
+}
+
+// index maps pool ids to symbols of l, it's built (entries != NULL) once
+// the list has TOKENIZE_LINEAR_SYMBOLS of them
+static err_t token_list_add_symbol(token_list *l, symbol_index_map *index,
+                                   const char *name, size_t length,
+                                   size_t *symbol_id) {
+    string_pool *pool = string_pool_global();
+    size_t i = 0, id = 0, new_capacity = 0, *found = NULL;
+    err_t err = 0;
+
+    if (pool == NULL) {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    err = string_pool_intern(pool, name, length, &id);
+    if (err) {
+        return err;
+    }
+
+    if (index->entries != NULL) {
+        found = symbol_index_map_get(index, id);
+        if (found != NULL) {
+            *symbol_id = *found;
+            return EXIT_SUCCESS;
+        }
+    } else {
+        for (i = 0; i < l->symbols_count; ++i) {
+            if (l->symbol_ids[i] == id) {
+                *symbol_id = i;
+                return EXIT_SUCCESS;
+            }
+        }
+    }
+
+    if (l->symbols_count == l->symbols_capacity) {
+        new_capacity = l->symbols_capacity == 0 ? 4 : l->symbols_capacity * 2;
+        err = token_list_grow(l, (void **)&l->symbols,
+                              l->symbols_capacity * sizeof(String),
+                              new_capacity * sizeof(String));
+        if (err) {
+            return err;
+        }
+        err = token_list_grow(l, (void **)&l->symbol_ids,
+                              l->symbols_capacity * sizeof(size_t),
+                              new_capacity * sizeof(size_t));
+        if (err) {
+            return err;
+        }
+        l->symbols_capacity = new_capacity;
+    }
+
+    *symbol_id = l->symbols_count;
+    l->symbols[l->symbols_count] = string_pool_string(pool, id);
+    l->symbol_ids[l->symbols_count++] = id;
+
+    if (index->entries != NULL) {
+        return symbol_index_map_set(index, id, *symbol_id);
+    }
+    if (l->symbols_count == TOKENIZE_LINEAR_SYMBOLS) {
+        err = symbol_index_map_init(index, 2 * TOKENIZE_LINEAR_SYMBOLS,
+                                    l->arena);
+        for (i = 0; !err && i < l->symbols_count; ++i) {
+            err = symbol_index_map_set(index, l->symbol_ids[i], i);
+        }
+    }
+
+    return err;
+}
+
+void token_list_fprint(FILE *out, const token_list *l) {
+    size_t i = 0;
+
+    if (l == NULL || l->size == 0) {
+        fprintf(out, "(nil)");
+        return;
+    }
+    for (i = 0; i < l->size; ++i) {
+        fwrite(l->source + l->tokens[i].offset, sizeof(char),
+               l->tokens[i].length, out);
+        putc(' ', out);
+    }
+}
+
+static err_t tokenize_operator(const char *line, size_t offset, size_t length,
+                               hash_table *operators, String *scratch,
+                               token *t) {
+    err_t err = 0;
+    operator_t *op = NULL;
+
+    string_clear(*scratch);
+    err = string_append(scratch, line + offset, length);
+    if (err) {
+        log_error("failed push to string");
+        return err;
+    }
+
+    stats_count(stats_hash_lookups, 1);
+    err = hash_table_get(operators, scratch, (void **)&op);
+    if (err == KEY_NOT_FOUND) {
+        log_error("operator is not registered in the table");
+        return INVALID_SYMBOL;
+    }
+    if (err) {
+        log_error("failed to get operator from hash table");
+        return err;
+    }
+
+    t->kind = token_operator;
+    t->op = op;
+
+    return EXIT_SUCCESS;
+}
+
+// arena scratch and index are left to the arena
+static void tokenize_release(memory_arena *arena, String scratch,
+                             symbol_index_map *index) {
+    if (arena == NULL) {
+        string_free(scratch);
+    }
+    symbol_index_map_free(index);
+}
+
+err_t tokenize(const char *line, int (*is_operand)(int c),
+               int (*is_operator)(const char *op), hash_table *operators,
+               memory_arena *arena, token_list **tokens) {
+    if (line == NULL || is_operand == NULL || is_operator == NULL ||
+        operators == NULL || tokens == NULL) {
+        log_error("passed NULL ptr");
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    token_list *list = NULL;
+    token t;
+    String scratch = NULL;  // key for operator lookups
+    symbol_index_map index;
+    size_t i = 0, length = 0, len = strlen(line);
+    char c = 0;
+    err_t err = 0;
+
+    err = token_list_init(&list, line, arena);
+    if (err) {
+        return err;
+    }
+    index.entries = NULL;
+    index.arena = arena;
+    // operator is never longer than the line, so arena scratch won't grow
+    if (arena != NULL) {
+        scratch = string_arena_copy(arena, line, len);
+    } else {
+        scratch = string_init();
+    }
+    if (scratch == NULL) {
+        log_error("failed to allocate memory for string");
+        token_list_free(list);
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    i = 0;
+    while (i < len) {
+        c = line[i];
+        t.op = NULL;
+        t.symbol_id = 0;
+        t.value = 0;
+        t.offset = i;
+
+        length = is_operator(line + i);
+        if (length > 0) {
+            err = tokenize_operator(line, i, length, operators, &scratch, &t);
+        } else if (c == '(') {
+            t.kind = token_left_brace;
+            length = 1;
+        } else if (c == ')') {
+            t.kind = token_right_brace;
+            length = 1;
+        } else if (is_operand((unsigned char)c)) {
+            while (i + length < len &&
+                   is_operand((unsigned char)line[i + length])) {
+                length++;
+            }
+            // digits only make a number, "1a" is a variable name
+            err = isdigit((unsigned char)c)
+                      ? parse_decimal_int(line + i, length, &t.value)
+                      : INVALID_NUMBER;
+            if (err == EXIT_SUCCESS) {
+                t.kind = token_number;
+            } else if (err == NUMBER_OVERFLOW) {
+                log_error("number doesn't fit in int");
+            } else {
+                t.kind = token_variable;
+                err = token_list_add_symbol(list, &index, line + i, length,
+                                            &t.symbol_id);
+            }
+        } else if (c == ' ') {
+            i++;
+            continue;
+        } else {
+            log_error("invalid symbol '%c' found", c);
+            err = INVALID_SYMBOL;
+        }
+        if (err) {
+            tokenize_release(arena, scratch, &index);
+            token_list_free(list);
+            return err;
+        }
+
+        t.length = length;
+        err = token_list_push(list, &t);
+        if (err) {
+            log_error("failed push to token list");
+            tokenize_release(arena, scratch, &index);
+            token_list_free(list);
+            return err;
+        }
+        i += length;
+    }
+
+    tokenize_release(arena, scratch, &index);
+    *tokens = list;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,74 @@
+#ifndef LEXER_H_
+#define LEXER_H_
+
+#include <stdio.h>
+
+#include "../libc/cstring.h"
+#include "../libc/errors.h"
+#include "../libc/hash_table.h"
+#include "../libc/memory.h"
+
+typedef enum { unary, binary } operator_type;
+
+typedef struct {
+    operator_type type;
+    int priority;
+    int (*func)(int, ...);
+} operator_t;
+
+typedef enum {
+    token_number,
+    token_variable,
+    token_operator,
+    token_left_brace,
+    token_right_brace
+} token_kind;
+
+typedef struct {
+    token_kind kind;
+    const operator_t *op;  // resolved operator, only for token_operator
+    size_t symbol_id;      // index in symbols, only for token_variable
+    int value;             // literal value, only for token_number
+    size_t offset;         // position of the token in the source line
+    size_t length;
+} token;
+
+typedef struct {
+    const char *source;  // scanned line, not owned
+    token *tokens;
+    size_t size;
+    size_t capacity;
+    // distinct variable names in order of appearance, canonical strings of
+    // string_pool_global() with their ids
+    String *symbols;
+    size_t *symbol_ids;
+    size_t symbols_count;
+    size_t symbols_capacity;
+    memory_arena *arena;  // storage of the list, NULL for heap
+} token_list;
+
+// with arena list lives until the arena is reset, token_list_free is a no-op
+err_t token_list_init(token_list **l, const char *source,
+                      memory_arena *arena);
+void token_list_free(token_list *l);
+
+// memory for arrays that replace list ones, from where the list keeps its own
+void *token_list_alloc(token_list *l, size_t size);
+void token_list_release(token_list *l, void *ptr);
+
+err_t token_list_push(token_list *l, const token *t);
+
+// prints tokens separated (and terminated) by spaces, "(nil)" if empty
+void token_list_fprint(FILE *out, const token_list *l);
+
+/*
+ * Scans line once. Operators are resolved through the operators table,
+ * variables get ids in order of their first appearance. Line should stay
+ * alive while tokens are used. Tokens are allocated from arena unless it's
+ * NULL.
+ */
+err_t tokenize(const char *line, int (*is_operand)(int c),
+               int (*is_operator)(const char *op), hash_table *operators,
+               memory_arena *arena, token_list **tokens);
+
+#endif  // !LEXER_H_
@@ -2,9 +2,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "../libc/cstring.h"
 #include "../libc/logger.h"
 #include "calculate.h"
 #include "cli.h"
+#include "server.h"
+#include "stats.h"
 #include "table.h"
 
 int main(int argc, char *argv[]) {
@@ -12,46 +15,81 @@ int main(int argc, char *argv[]) {
     u_list *files = NULL;
     u_list_node *current = NULL;
     file_to_process *current_data = NULL;
+    cli_options options;
+    stats file_stats;
 
     err = logger_start();
     if (err) {
         return err;
     }
     log_set_level(LOG_TRACE);
+    atexit(log_stop_async);  // drains records on every way out
+    atexit(string_pool_global_free);
     err = u_list_init(&files, sizeof(file_to_process), file_to_process_free);
     if (err) {
         u_list_free(files);
         return err;
     }
-    err = parse_cli_arguments(files, argc, argv);
+    err = parse_cli_arguments(files, &options, argc, argv);
     if (err) {
         u_list_free(files);
         return err;
     }
+    if (options.output.format != format_human) {
+        // stdout carries records only, diagnostics go aside
+        log_replace_fp(stdout, stderr);
+        // logs no longer share a stream with results, so ordering is free
+        err = log_start_async(LOG_ASYNC_CAPACITY);
+        if (err) {
+            u_list_free(files);
+            return err;
+        }
+    }
 
     current = files->first;
     while (current != NULL) {
-        current_data = current->data;
+        current_data = (file_to_process *)current->data;
+        if (options.stats) {
+            stats_begin(&file_stats);
+        }
         switch (current_data->op) {
             case calculate:
-                err = process_calculate_file(current_data);
+                err = process_calculate_file(current_data, &options.output);
                 if (err) {
                     u_list_free(files);
                     return err;
                 }
                 break;
             case table:
-                err = process_table_file(current_data);
+                err = process_table_file(current_data, &options.output);
                 if (err) {
                     u_list_free(files);
                     return err;
                 }
                 break;
         }
+        if (options.stats) {
+            stats_end(&file_stats);
+            log_flush();  // keep this file's diagnostics above its stats
+            stats_fprint(stderr, current_data->filename, &file_stats,
+                         options.output.format);
+        }
         current = current->next;
     }
 
     u_list_free(files);
+
+    if (options.serve_path != NULL) {
+        err = log_start_async(LOG_ASYNC_CAPACITY);
+        if (err) {
+            return err;
+        }
+        err = serve(options.serve_path);
+        if (err) {
+            return err;
+        }
+    }
+
     // i ain't closing logger bc i use it only for errors,
     // check logger.c/logger_start()
     return EXIT_SUCCESS;
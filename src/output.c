@@ -0,0 +1,221 @@
+#include "output.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../libc/cstring.h"
+#include "../libc/logger.h"
+#include "../libc/types.h"
+
+const output_options output_default_options = {format_human, EMIT_ALL};
+
+err_t output_parse_format(const char *value, output_format *format) {
+    if (value == NULL || format == NULL) {
+        log_error("passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    if (strcmp(value, "human") == 0) {
+        *format = format_human;
+    } else if (strcmp(value, "jsonl") == 0) {
+        *format = format_jsonl;
+    } else if (strcmp(value, "tsv") == 0) {
+        *format = format_tsv;
+    } else {
+        log_error("unknown output format %s", value);
+        return INVALID_CLI_ARGUMENT;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+err_t output_parse_emit(const char *value, unsigned int *emit) {
+    if (value == NULL || emit == NULL) {
+        log_error("passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    const char *name = value;
+    size_t length = 0;
+
+    *emit = 0;
+    while (1) {
+        length = strcspn(name, ",");
+        if (length == 6 && strncmp(name, "result", 6) == 0) {
+            *emit |= EMIT_RESULT;
+        } else if (length == 7 && strncmp(name, "postfix", 7) == 0) {
+            *emit |= EMIT_POSTFIX;
+        } else if (length == 4 && strncmp(name, "tree", 4) == 0) {
+            *emit |= EMIT_TREE;
+        } else if (length == 5 && strncmp(name, "table", 5) == 0) {
+            *emit |= EMIT_TABLE;
+        } else {
+            log_error("unknown output section %.*s", (int)length, name);
+            return INVALID_CLI_ARGUMENT;
+        }
+        if (name[length] == '\0') {
+            break;
+        }
+        name += length + 1;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+void output_escaped(FILE *out, output_format format, const char *text,
+                    size_t length) {
+    size_t i = 0, plain = 0;
+    unsigned char c = 0;
+
+    for (i = 0; i < length; ++i) {
+        c = text[i];
+        if (c >= 0x20 && c != '\\' && !(format == format_jsonl && c == '"')) {
+            continue;
+        }
+        fwrite(text + plain, sizeof(char), i - plain, out);
+        plain = i + 1;
+        switch (c) {
+            case '\n':
+                fputs("\\n", out);
+                break;
+            case '\t':
+                fputs("\\t", out);
+                break;
+            case '\r':
+                fputs("\\r", out);
+                break;
+            case '\\':
+                fputs("\\\\", out);
+                break;
+            case '"':
+                fputs("\\\"", out);
+                break;
+            default:
+                if (format == format_jsonl) {
+                    fprintf(out, "\\u%04x", c);
+                } else {
+                    putc(' ', out);
+                }
+                break;
+        }
+    }
+    fwrite(text + plain, sizeof(char), length - plain, out);
+}
+
+void output_int(FILE *out, int value) {
+    char text[TYPES_INT_TEXT_SIZE];
+
+    fwrite(text, sizeof(char), format_int(value, text), out);
+}
+
+void output_size(FILE *out, size_t value) {
+    char text[TYPES_UINT64_TEXT_SIZE];
+
+    fwrite(text, sizeof(char), format_uint64((uint64_t)value, text), out);
+}
+
+void output_record_begin(FILE *out, const output_context *context) {
+    const char *filename = context->filename;
+
+    if (context->options->format == format_jsonl) {
+        fputs("{\"file\":\"", out);
+        output_escaped(out, format_jsonl, filename, strlen(filename));
+        fputs("\",\"line\":", out);
+        output_size(out, context->line);
+    } else {
+        output_escaped(out, format_tsv, filename, strlen(filename));
+        putc('\t', out);
+        output_size(out, context->line);
+        fputs("\tok", out);
+    }
+}
+
+void output_record_field(FILE *out, const output_context *context,
+                         const char *name) {
+    if (context->options->format == format_jsonl) {
+        fprintf(out, ",\"%s\":", name);
+    } else {
+        putc('\t', out);
+    }
+}
+
+void output_record_end(FILE *out, const output_context *context) {
+    if (context->options->format == format_jsonl) {
+        putc('}', out);
+    }
+    putc('\n', out);
+}
+
+void output_error_record(FILE *out, const output_context *context,
+                         const char *description) {
+    const char *filename = context->filename;
+    output_format format = context->options->format;
+
+    if (format == format_jsonl) {
+        fputs("{\"file\":\"", out);
+        output_escaped(out, format, filename, strlen(filename));
+        fputs("\",\"line\":", out);
+        output_size(out, context->line);
+        fputs(",\"error\":\"", out);
+        output_escaped(out, format, description, strlen(description));
+        fputs("\"}\n", out);
+    } else {
+        output_escaped(out, format, filename, strlen(filename));
+        putc('\t', out);
+        output_size(out, context->line);
+        fputs("\terror\t", out);
+        output_escaped(out, format, description, strlen(description));
+        putc('\n', out);
+    }
+}
+
+void output_postfix(FILE *out, const output_context *context,
+                    const token_list *postfix) {
+    output_format format = context->options->format;
+    size_t i = 0;
+
+    if (format == format_jsonl) {
+        putc('"', out);
+    }
+    for (i = 0; i < postfix->size; ++i) {
+        if (i > 0) {
+            putc(' ', out);
+        }
+        output_escaped(out, format, postfix->source + postfix->tokens[i].offset,
+                       postfix->tokens[i].length);
+    }
+    if (format == format_jsonl) {
+        putc('"', out);
+    }
+}
+
+err_t output_tree(FILE *out, const output_context *context,
+                  expression_tree *tree) {
+    output_format format = context->options->format;
+    String buffer = NULL;
+    err_t err = 0;
+
+    buffer = string_init();
+    if (buffer == NULL) {
+        log_error("failed to allocate memory for tree picture");
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    if (tree != NULL) {
+        err = expression_tree_render(tree, &buffer);
+        if (err) {
+            string_free(buffer);
+            return err;
+        }
+    }
+
+    if (format == format_jsonl) {
+        putc('"', out);
+    }
+    output_escaped(out, format, buffer, string_len(buffer));
+    if (format == format_jsonl) {
+        putc('"', out);
+    }
+
+    string_free(buffer);
+    return EXIT_SUCCESS;
+}
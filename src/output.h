@@ -0,0 +1,70 @@
+#ifndef OUTPUT_H_
+#define OUTPUT_H_
+
+#include <stdio.h>
+
+#include "../libc/errors.h"
+#include "expression_tree.h"
+#include "lexer.h"
+
+typedef enum { format_human, format_jsonl, format_tsv } output_format;
+
+// sections of processed line output, selected by --emit
+#define EMIT_RESULT (1 << 0)
+#define EMIT_POSTFIX (1 << 1)
+#define EMIT_TREE (1 << 2)
+#define EMIT_TABLE (1 << 3)
+#define EMIT_ALL (EMIT_RESULT | EMIT_POSTFIX | EMIT_TREE | EMIT_TABLE)
+
+typedef struct {
+    output_format format;
+    unsigned int emit;  // EMIT_* flags, sections that are not set aren't
+                        // even computed
+} output_options;
+
+// human format with every section, what CLI printed before --format
+extern const output_options output_default_options;
+
+/*
+ * Line that is being processed. filename and line are used only by machine
+ * readable formats, which write exactly one record per line:
+ *
+ *     jsonl: {"file":"f","line":0,"postfix":"a b +","result":3}
+ *            {"file":"f","line":1,"error":"Invalid braces placement error."}
+ *     tsv:   f<TAB>0<TAB>ok<TAB>a b +<TAB>3
+ *            f<TAB>1<TAB>error<TAB>Invalid braces placement error.
+ *
+ * Sections go in postfix, result, tree, table order, only emitted ones that
+ * make sense for the line. Multiline sections are escaped.
+ */
+typedef struct {
+    const output_options *options;
+    const char *filename;
+    size_t line;
+} output_context;
+
+err_t output_parse_format(const char *value, output_format *format);
+// value is comma separated list of section names
+err_t output_parse_emit(const char *value, unsigned int *emit);
+
+void output_escaped(FILE *out, output_format format, const char *text,
+                    size_t length);
+// decimal numbers without printf
+void output_int(FILE *out, int value);
+void output_size(FILE *out, size_t value);
+
+void output_record_begin(FILE *out, const output_context *context);
+// starts next section of the record, its value should follow
+void output_record_field(FILE *out, const output_context *context,
+                         const char *name);
+void output_record_end(FILE *out, const output_context *context);
+void output_error_record(FILE *out, const output_context *context,
+                         const char *description);
+
+// tokens separated by single spaces, as json string or escaped tsv field
+void output_postfix(FILE *out, const output_context *context,
+                    const token_list *postfix);
+err_t output_tree(FILE *out, const output_context *context,
+                  expression_tree *tree);
+
+#endif  // !OUTPUT_H_
@@ -0,0 +1,207 @@
+#include "parser.h"
+
+#include <limits.h>
+#include <stdlib.h>
+
+#include "../libc/logger.h"
+
+typedef struct {
+    const token *input;  // infix tokens
+    size_t size;
+    size_t position;
+    token *output;  // postfix tokens
+    size_t output_size;
+    const char *source;
+    expression_tree *tree;  // NULL unless tree is built
+} parser;
+
+// emits token to postfix output and appends tree node for it if needed,
+// node index is the token's position in postfix
+static void parser_emit(parser *p, const token *t, uint32_t left,
+                        uint32_t right, uint32_t *node) {
+    p->output[p->output_size] = *t;
+    if (p->tree != NULL) {
+        expression_tree_append(p->tree, t, p->source, left, right);
+    }
+    *node = (uint32_t)p->output_size++;
+}
+
+static err_t parser_parse_expression(parser *p, int min_priority,
+                                     uint32_t *node, int *empty);
+
+// operand, prefix operator application or braced expression
+static err_t parser_parse_operand(parser *p, uint32_t *node, int *empty) {
+    const token *t = NULL;
+    uint32_t operand = EXPRESSION_TREE_NO_CHILD;
+    int operand_empty = 0;
+    err_t err = 0;
+
+    *empty = 0;
+
+    if (p->position == p->size) {
+        log_error("operand expected, but expression ended");
+        return INVALID_OPERATIONS;
+    }
+    t = p->input + p->position++;
+
+    switch (t->kind) {
+        case token_number:
+        case token_variable:
+            parser_emit(p, t, EXPRESSION_TREE_NO_CHILD,
+                        EXPRESSION_TREE_NO_CHILD, node);
+            return EXIT_SUCCESS;
+        case token_left_brace:
+            if (p->position < p->size &&
+                p->input[p->position].kind == token_right_brace) {
+                p->position++;  // "()" is an empty expression
+                *empty = 1;
+                return EXIT_SUCCESS;
+            }
+            err = parser_parse_expression(p, INT_MIN, node, empty);
+            if (err) {
+                return err;
+            }
+            if (p->position == p->size ||
+                p->input[p->position].kind != token_right_brace) {
+                log_error("closing brace expected");
+                return INVALID_BRACES;
+            }
+            p->position++;
+            return EXIT_SUCCESS;
+        case token_right_brace:
+            log_error("unexpected closing brace");
+            return INVALID_BRACES;
+        default:  // operator
+            if (t->op->type != unary) {
+                log_error("operand expected, but binary operator found");
+                return INVALID_OPERATIONS;
+            }
+            err = parser_parse_expression(p, t->op->priority + 1, &operand,
+                                          &operand_empty);
+            if (err) {
+                return err;
+            }
+            if (operand_empty) {
+                log_error("unary operator without operand");
+                return INVALID_OPERATIONS;
+            }
+            parser_emit(p, t, operand, EXPRESSION_TREE_NO_CHILD, node);
+            return EXIT_SUCCESS;
+    }
+}
+
+// binary operators are left associative
+static err_t parser_parse_expression(parser *p, int min_priority,
+                                     uint32_t *node, int *empty) {
+    const token *t = NULL;
+    uint32_t right = EXPRESSION_TREE_NO_CHILD;
+    int right_empty = 0;
+    err_t err = 0;
+
+    err = parser_parse_operand(p, node, empty);
+    if (err || *empty) {
+        return err;
+    }
+
+    while (p->position < p->size) {
+        t = p->input + p->position;
+        if (t->kind != token_operator || t->op->type != binary ||
+            t->op->priority < min_priority) {
+            break;
+        }
+        p->position++;
+
+        err = parser_parse_expression(p, t->op->priority + 1, &right,
+                                      &right_empty);
+        if (err) {
+            return err;
+        }
+        if (right_empty) {
+            log_error("binary operator without right operand");
+            return INVALID_OPERATIONS;
+        }
+
+        parser_emit(p, t, *node, right, node);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+err_t parse_tokens(token_list *tokens, expression_tree **tree) {
+    if (tokens == NULL) {
+        log_error("passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    parser p;
+    uint32_t root = EXPRESSION_TREE_NO_CHILD;
+    size_t i = 0, text = 0;
+    int empty = 0;
+    err_t err = 0;
+
+    if (tree != NULL) {
+        *tree = NULL;
+    }
+    if (tokens->size == 0) {
+        return EXIT_SUCCESS;
+    }
+
+    p.input = tokens->tokens;
+    p.size = tokens->size;
+    p.position = 0;
+    p.source = tokens->source;
+    p.tree = NULL;
+    p.output_size = 0;
+    // postfix form is never longer than infix one
+    p.output =
+        (token *)token_list_alloc(tokens, tokens->capacity * sizeof(token));
+    if (p.output == NULL) {
+        log_error("Failed to allocate memory for postfix tokens");
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    // same bound holds for nodes and their labels
+    if (tree != NULL) {
+        for (i = 0; i < tokens->size; ++i) {
+            text += tokens->tokens[i].length;
+        }
+        err = expression_tree_init(&p.tree, tokens->size,
+                                   tokens->symbols_count, text,
+                                   tokens->arena);
+        if (err) {
+            token_list_release(tokens, p.output);
+            return err;
+        }
+    }
+
+    err = parser_parse_expression(&p, INT_MIN, &root, &empty);
+    if (err == EXIT_SUCCESS && p.position < p.size) {
+        if (p.input[p.position].kind == token_right_brace) {
+            log_error("unexpected closing brace");
+            err = INVALID_BRACES;
+        } else {
+            log_error("operator expected");
+            err = INVALID_OPERATIONS;
+        }
+    }
+    if (err) {
+        expression_tree_free(p.tree);
+        token_list_release(tokens, p.output);
+        return err;
+    }
+
+    token_list_release(tokens, tokens->tokens);
+    tokens->tokens = p.output;
+    tokens->size = p.output_size;
+
+    if (tree != NULL && p.output_size == 0) {  // "()" has no nodes
+        expression_tree_free(p.tree);
+        p.tree = NULL;
+    }
+    if (p.tree != NULL) {
+        expression_tree_finish(p.tree);
+        *tree = p.tree;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,17 @@
+#ifndef PARSER_H_
+#define PARSER_H_
+
+#include "../libc/errors.h"
+#include "expression_tree.h"
+#include "lexer.h"
+
+/*
+ * Parses infix tokens by precedence climbing in one pass. Tokens are
+ * reordered to postfix notation in place (braces are dropped), empty
+ * formula gives no tokens. Unless tree is NULL, the expression tree is
+ * built in the same pass, a node per emitted token, where the token list
+ * lives; empty formula gives NULL tree.
+ */
+err_t parse_tokens(token_list *tokens, expression_tree **tree);
+
+#endif  // !PARSER_H_
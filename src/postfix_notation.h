@@ -1,24 +1,27 @@
 #ifndef POSTFIX_NOTATION_H_
 #define POSTFIX_NOTATION_H_
 
-#include "../libc/cstring.h"
 #include "../libc/errors.h"
-#include "../libc/hash_table.h"
+#include "../libc/memory.h"
+#include "../libc/vector.h"
+#include "lexer.h"
 
-typedef enum { unary, binary } operator_type;
+// evaluation stack, values are pushed and popped by value instead of being
+// memcpy'd through void pointers like the generic stacks do
+DEFINE_VECTOR(int_vector, int)
 
-typedef struct {
-    operator_type type;
-    int priority;
-    int (*func)(int, ...);
-} operator_t;
+// checks operands of every operator and gives the deepest evaluation stack
+err_t postfix_stack_depth(const token_list *postfix, size_t *max_depth);
 
-err_t infix_to_postfix(const String infix_exp, int (*is_operand)(int c),
-                       int (*is_operator)(const char *op),
-                       int (*priority_mapper)(const String op),
-                       String *postfix_exp);
+// evaluates postfix checked by postfix_stack_depth on empty stack reserved
+// for its max depth, nothing is checked or allocated on the way
+int postfix_evaluate(const token_list *postfix, const int *symbol_values,
+                     int_vector *stack);
 
-err_t calculate_postfix_expression(const String postfix_exp,
-                                   int *expression_result,
-                                   hash_table *operators, hash_table *operands);
+// symbol_values holds value for every symbol of postfix tokens, evaluation
+// stack is taken from arena (and given back) unless it's NULL
+err_t calculate_postfix_expression(const token_list *postfix,
+                                   const int *symbol_values,
+                                   memory_arena *arena,
+                                   int *expression_result);
 #endif  // !POSTFIX_NOTATION_H_
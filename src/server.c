@@ -0,0 +1,657 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "server.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../libc/hash_table.h"
+#include "../libc/logger.h"
+#include "../libc/memory.h"
+#include "calculate.h"
+#include "cli.h"
+#include "output.h"
+#include "table.h"
+
+#define SERVER_MAX_EVENTS (64)
+#define SERVER_BACKLOG (64)
+// pending output over it holds back answering further lines
+#define SERVER_OUTPUT_HIGH_WATER (64 * 1024)
+
+typedef struct server_connection {
+    int fd;
+    char input[BUFSIZ];
+    size_t input_len;
+    int input_overflow;  // current line didn't fit, skipping until '\n'
+    char *output;
+    size_t output_len;
+    size_t output_sent;
+    size_t output_capacity;
+    struct server_connection *prev, *next;
+} server_connection;
+
+typedef struct {
+    int epoll_fd;
+    int listen_fd;
+    hash_table *calculate_operators;
+    hash_table *calculate_operands;  // bindings of the current request
+    hash_table *table_operators;
+    memory_arena *arena;  // reset after every request
+    server_connection *connections;
+} server_state;
+
+static volatile sig_atomic_t server_stop_requested = 0;
+
+static void server_signal_handler(int signal_number) {
+    (void)signal_number;
+    server_stop_requested = 1;
+}
+
+static err_t server_set_signal_handlers(void) {
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = SIG_IGN;
+    if (sigaction(SIGPIPE, &action, NULL) == -1) {
+        return INVALID_INPUT_DATA;
+    }
+
+    action.sa_handler = server_signal_handler;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGINT, &action, NULL) == -1 ||
+        sigaction(SIGTERM, &action, NULL) == -1) {
+        return INVALID_INPUT_DATA;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static int server_set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags == -1) {
+        return -1;
+    }
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// socket left by a previous run is removed, anything else at the path is
+// left alone
+static err_t server_remove_stale_socket(const char *socket_path) {
+    struct stat status;
+
+    if (lstat(socket_path, &status) == -1) {
+        if (errno == ENOENT) {
+            return EXIT_SUCCESS;
+        }
+        log_error("failed to check %s: %s", socket_path, strerror(errno));
+        return OPENING_THE_FILE_ERROR;
+    }
+    if (!S_ISSOCK(status.st_mode)) {
+        log_error("%s exists and is not a socket", socket_path);
+        return OPENING_THE_FILE_ERROR;
+    }
+    if (unlink(socket_path) == -1) {
+        log_error("failed to remove %s: %s", socket_path, strerror(errno));
+        return OPENING_THE_FILE_ERROR;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static err_t server_listen(const char *socket_path, int *listen_fd) {
+    struct sockaddr_un address;
+    int fd = -1;
+    err_t err = 0;
+
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        log_error("socket path %s is too long", socket_path);
+        return INVALID_CLI_ARGUMENT;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        log_error("failed to create socket: %s", strerror(errno));
+        return OPENING_THE_FILE_ERROR;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+
+    err = server_remove_stale_socket(socket_path);
+    if (err) {
+        close(fd);
+        return err;
+    }
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) == -1 ||
+        listen(fd, SERVER_BACKLOG) == -1 || server_set_nonblocking(fd) == -1) {
+        log_error("failed to listen on %s: %s", socket_path, strerror(errno));
+        close(fd);
+        return OPENING_THE_FILE_ERROR;
+    }
+
+    *listen_fd = fd;
+    return EXIT_SUCCESS;
+}
+
+static void server_connection_close(server_state *state,
+                                    server_connection *connection) {
+    if (connection == NULL) {
+        return;
+    }
+
+    epoll_ctl(state->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+
+    if (connection->prev != NULL) {
+        connection->prev->next = connection->next;
+    } else {
+        state->connections = connection->next;
+    }
+    if (connection->next != NULL) {
+        connection->next->prev = connection->prev;
+    }
+
+    free(connection->output);
+    free(connection);
+}
+
+static err_t server_accept(server_state *state) {
+    struct epoll_event event;
+    server_connection *connection = NULL;
+    int fd = -1;
+
+    while (1) {
+        fd = accept(state->listen_fd, NULL, NULL);
+        if (fd == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                return EXIT_SUCCESS;
+            }
+            log_error("accept failed: %s", strerror(errno));
+            return EXIT_SUCCESS;  // keep serving other clients
+        }
+
+        if (server_set_nonblocking(fd) == -1) {
+            log_error("failed to make client socket non-blocking");
+            close(fd);
+            continue;
+        }
+
+        connection = (server_connection *)malloc(sizeof(server_connection));
+        if (connection == NULL) {
+            log_error("failed to allocate memory for connection");
+            close(fd);
+            return MEMORY_ALLOCATION_ERROR;
+        }
+        connection->fd = fd;
+        connection->input_len = 0;
+        connection->input_overflow = 0;
+        connection->output = NULL;
+        connection->output_len = 0;
+        connection->output_sent = 0;
+        connection->output_capacity = 0;
+
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        if (epoll_ctl(state->epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            log_error("failed to register client: %s", strerror(errno));
+            close(fd);
+            free(connection);
+            continue;
+        }
+
+        connection->prev = NULL;
+        connection->next = state->connections;
+        if (state->connections != NULL) {
+            state->connections->prev = connection;
+        }
+        state->connections = connection;
+    }
+}
+
+static err_t server_connection_append(server_connection *connection,
+                                      const char *data, size_t len) {
+    err_t err = 0;
+    size_t new_capacity = 0;
+
+    if (connection->output_len + len > connection->output_capacity) {
+        new_capacity = connection->output_capacity == 0
+                           ? BUFSIZ
+                           : connection->output_capacity;
+        while (new_capacity < connection->output_len + len) {
+            new_capacity *= 2;
+        }
+        err = rerealloc((void **)&connection->output, new_capacity);
+        if (err) {
+            return err;
+        }
+        connection->output_capacity = new_capacity;
+    }
+
+    memcpy(connection->output + connection->output_len, data, len);
+    connection->output_len += len;
+
+    return EXIT_SUCCESS;
+}
+
+// "a=1 b=-2": whitespace separated bindings stored to operands
+static err_t server_bind_variables(server_state *state, char *bindings) {
+    char *name = NULL, *end = NULL;
+    size_t name_length = 0, id = 0;
+    long value = 0;
+    int number = 0;
+    err_t err = 0;
+
+    while (1) {
+        while (isspace((unsigned char)*bindings)) {
+            bindings++;
+        }
+        if (*bindings == '\0') {
+            return EXIT_SUCCESS;
+        }
+
+        name = bindings;
+        while (isalnum((unsigned char)*bindings)) {
+            bindings++;
+        }
+        name_length = (size_t)(bindings - name);
+        if (name_length == 0 || isdigit((unsigned char)name[0]) ||
+            *bindings != '=') {
+            log_error("invalid binding %s", name);
+            return INVALID_BINDING;
+        }
+
+        bindings++;
+        if (!isdigit((unsigned char)*bindings) && *bindings != '-') {
+            log_error("invalid binding %s", name);
+            return INVALID_BINDING;
+        }
+        errno = 0;
+        value = strtol(bindings, &end, 10);
+        if (end == bindings ||
+            (*end != '\0' && !isspace((unsigned char)*end))) {
+            log_error("invalid binding %s", name);
+            return INVALID_BINDING;
+        }
+        if (errno == ERANGE || value < INT_MIN || value > INT_MAX) {
+            return NUMBER_OVERFLOW;
+        }
+        bindings = end;
+        number = (int)value;
+
+        err = string_pool_intern(string_pool_global(), name, name_length,
+                                 &id);
+        if (!err) {
+            err = hash_table_set(state->calculate_operands, &id, &number);
+        }
+        if (err) {
+            log_error("failed to store variable binding");
+            return err;
+        }
+    }
+}
+
+static err_t server_calculate(server_state *state, char *request, FILE *out,
+                              const output_context *context) {
+    char *bindings = strchr(request, ';');
+    err_t err = 0;
+
+    if (bindings != NULL) {
+        *bindings = '\0';
+        err = server_bind_variables(state, bindings + 1);
+    }
+    if (!err) {
+        err = process_calculate_line(request, state->calculate_operators,
+                                     state->calculate_operands, out, NULL,
+                                     context, state->arena);
+    }
+    if (bindings != NULL) {
+        *bindings = ';';  // request is quoted whole in errors
+    }
+
+    return err;
+}
+
+static void server_respond(server_state *state, char *request, FILE *out) {
+    err_t err = 0;
+    const char *error_description = NULL;
+    output_context context = {&output_default_options, NULL, 0};
+
+    if (strncmp(request, "calculate ", 10) == 0) {
+        err = server_calculate(state, request + 10, out, &context);
+        hash_table_clear(state->calculate_operands);
+    } else if (strncmp(request, "table ", 6) == 0) {
+        err = process_table_line(request + 6, state->table_operators, out,
+                                 &context, state->arena);
+    } else {
+        fprintf(out, "[%s] - Unknown request.\n", request);
+        fprintf(out, "Error occured. Skipping...\n\n");
+        return;
+    }
+
+    memory_arena_reset(state->arena);
+    // ids are only kept by the request, so names of one client don't pile
+    // up in a pool that lives as long as the server
+    string_pool_clear(string_pool_global());
+
+    if (err == EXIT_SUCCESS) {
+        fprintf(out, "Ok.\n\n");
+        return;
+    }
+
+    error_description = cli_error_description(err);
+    if (error_description == NULL) {
+        log_error("failed to process request, error %d", err);
+        error_description = "Internal error.";
+    }
+    fprintf(out, "[%s] - %s\n", request, error_description);
+    fprintf(out, "Error occured. Skipping...\n\n");
+}
+
+static err_t server_handle_line(server_state *state,
+                                server_connection *connection, char *line) {
+    char *response = NULL;
+    size_t response_len = 0, len = strlen(line);
+    FILE *out = NULL;
+    err_t err = 0;
+
+    if (len > 0 && line[len - 1] == '\r') {
+        line[len - 1] = '\0';
+    }
+    if (line[0] == '\0') {
+        return EXIT_SUCCESS;
+    }
+
+    out = open_memstream(&response, &response_len);
+    if (out == NULL) {
+        log_error("failed to open response stream");
+        return MEMORY_ALLOCATION_ERROR;
+    }
+    server_respond(state, line, out);
+    if (fclose(out) != 0) {
+        free(response);
+        log_error("failed to write response");
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    err = server_connection_append(connection, response, response_len);
+    free(response);
+
+    return err;
+}
+
+// returns 1 if everything was sent, 0 if socket is full, -1 on failure
+static int server_connection_flush(server_connection *connection) {
+    ssize_t written = 0;
+
+    while (connection->output_sent < connection->output_len) {
+        written = write(connection->fd,
+                        connection->output + connection->output_sent,
+                        connection->output_len - connection->output_sent);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            return -1;
+        }
+        connection->output_sent += written;
+    }
+
+    connection->output_len = 0;
+    connection->output_sent = 0;
+
+    return 1;
+}
+
+// requests are not read while responses or held back lines wait, so a
+// client that doesn't read can't make its output grow
+static int server_connection_has_line(const server_connection *connection) {
+    return memchr(connection->input, '\n', connection->input_len) != NULL;
+}
+
+static err_t server_connection_update_events(server_state *state,
+                                             server_connection *connection,
+                                             int wants_input) {
+    struct epoll_event event;
+
+    event.events = wants_input ? EPOLLIN : EPOLLOUT;
+    event.data.ptr = connection;
+    if (epoll_ctl(state->epoll_fd, EPOLL_CTL_MOD, connection->fd, &event) ==
+        -1) {
+        log_error("failed to update client events: %s", strerror(errno));
+        return INVALID_STREAM_PTR;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// answers complete lines of input until responses pile up over
+// SERVER_OUTPUT_HIGH_WATER, the rest of input waits until they are sent
+static err_t server_connection_process(server_state *state,
+                                       server_connection *connection) {
+    static const char line_too_long[] =
+        "[] - Line is too long.\nError occured. Skipping...\n\n";
+    size_t start = 0, i = 0;
+    char *line = NULL;
+    err_t err = 0;
+
+    for (i = 0; i < connection->input_len &&
+                connection->output_len < SERVER_OUTPUT_HIGH_WATER;
+         ++i) {
+        if (connection->input[i] != '\n') {
+            continue;
+        }
+        connection->input[i] = '\0';
+        line = connection->input + start;
+        start = i + 1;
+
+        if (connection->input_overflow) {
+            connection->input_overflow = 0;
+            err = server_connection_append(connection, line_too_long,
+                                           strlen(line_too_long));
+        } else {
+            err = server_handle_line(state, connection, line);
+        }
+        if (err) {
+            return err;
+        }
+    }
+
+    connection->input_len -= start;
+    memmove(connection->input, connection->input + start,
+            connection->input_len);
+
+    if (connection->input_len == sizeof(connection->input) &&
+        !server_connection_has_line(connection)) {
+        connection->input_overflow = 1;  // drop the rest of this line
+        connection->input_len = 0;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// returns 1 if peer closed connection
+static int server_connection_read(server_state *state,
+                                  server_connection *connection, err_t *err) {
+    ssize_t received = 0;
+
+    *err = EXIT_SUCCESS;
+
+    received = read(connection->fd, connection->input + connection->input_len,
+                    sizeof(connection->input) - connection->input_len);
+    if (received == 0) {
+        return 1;
+    }
+    if (received == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return 0;
+        }
+        return 1;
+    }
+    connection->input_len += received;
+
+    *err = server_connection_process(state, connection);
+    return 0;
+}
+
+static void server_handle_connection(server_state *state,
+                                     server_connection *connection,
+                                     unsigned int events) {
+    err_t err = 0;
+    int closed = 0, flushed = 0;
+
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        closed = server_connection_read(state, connection, &err);
+    } else if (server_connection_flush(connection) == 1) {
+        // output drained, lines held back by it are answered now
+        err = server_connection_process(state, connection);
+    }
+    if (err) {
+        log_error("failed to handle request, error %d", err);
+        closed = 1;
+    }
+
+    flushed = server_connection_flush(connection);
+    if (closed || flushed == -1) {
+        server_connection_close(state, connection);
+        return;
+    }
+
+    if (server_connection_update_events(
+            state, connection,
+            flushed == 1 && !server_connection_has_line(connection))) {
+        server_connection_close(state, connection);
+    }
+}
+
+static void server_state_free(server_state *state) {
+    while (state->connections != NULL) {
+        server_connection_close(state, state->connections);
+    }
+    if (state->epoll_fd != -1) {
+        close(state->epoll_fd);
+    }
+    if (state->listen_fd != -1) {
+        close(state->listen_fd);
+    }
+    hash_table_free(state->calculate_operators);
+    hash_table_free(state->calculate_operands);
+    hash_table_free(state->table_operators);
+    memory_arena_free(state->arena);
+}
+
+err_t serve(const char *socket_path) {
+    if (socket_path == NULL) {
+        log_error("passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    server_state state;
+    struct epoll_event event, events[SERVER_MAX_EVENTS];
+    err_t err = 0;
+    int ready = 0, i = 0;
+
+    state.epoll_fd = -1;
+    state.listen_fd = -1;
+    state.calculate_operators = NULL;
+    state.calculate_operands = NULL;
+    state.table_operators = NULL;
+    state.arena = NULL;
+    state.connections = NULL;
+
+    err = calculate_init_hash_tables(&state.calculate_operators,
+                                     &state.calculate_operands);
+    if (err) {
+        return err;
+    }
+    err = table_init_hash_table(&state.table_operators);
+    if (err) {
+        server_state_free(&state);
+        return err;
+    }
+    err = memory_arena_init(&state.arena, MEMORY_ARENA_BLOCK_SIZE);
+    if (err) {
+        log_error("failed to allocate memory for request arena");
+        server_state_free(&state);
+        return err;
+    }
+
+    err = server_set_signal_handlers();
+    if (err) {
+        log_error("failed to set signal handlers");
+        server_state_free(&state);
+        return err;
+    }
+
+    err = server_listen(socket_path, &state.listen_fd);
+    if (err) {
+        server_state_free(&state);
+        return err;
+    }
+
+    state.epoll_fd = epoll_create1(0);
+    if (state.epoll_fd == -1) {
+        log_error("failed to create epoll instance: %s", strerror(errno));
+        server_state_free(&state);
+        unlink(socket_path);
+        return OPENING_THE_FILE_ERROR;
+    }
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;  // NULL marks the listening socket
+    if (epoll_ctl(state.epoll_fd, EPOLL_CTL_ADD, state.listen_fd, &event) ==
+        -1) {
+        log_error("failed to register socket: %s", strerror(errno));
+        server_state_free(&state);
+        unlink(socket_path);
+        return OPENING_THE_FILE_ERROR;
+    }
+
+    log_info("serving on %s", socket_path);
+
+    while (!server_stop_requested) {
+        ready = epoll_wait(state.epoll_fd, events, SERVER_MAX_EVENTS, -1);
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log_error("epoll_wait failed: %s", strerror(errno));
+            err = INVALID_STREAM_PTR;
+            break;
+        }
+
+        for (i = 0; i < ready; ++i) {
+            if (events[i].data.ptr == NULL) {
+                err = server_accept(&state);
+                if (err) {
+                    break;
+                }
+                continue;
+            }
+            server_handle_connection(&state, events[i].data.ptr,
+                                     events[i].events);
+        }
+        if (err) {
+            break;
+        }
+    }
+
+    log_info("shutting down");
+    server_state_free(&state);
+    unlink(socket_path);
+
+    return err;
+}
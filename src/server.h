@@ -0,0 +1,28 @@
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#include "../libc/errors.h"
+
+/*
+ * Long-running mode: listens on a unix domain socket and answers
+ * newline-delimited requests of the form
+ *
+ *     calculate <formula>[; <name>=<value> ...]
+ *     table <formula>
+ *
+ * with the same text the CLI prints for a line of a --calculate/--table
+ * file. Each response ends with an "Ok." or "Error occured. Skipping..."
+ * line followed by an empty line. Operator tables are built once and shared
+ * by all connections. Variables can not be prompted in this mode, their
+ * values follow the formula instead, e.g. "calculate a * b; a=2 b=-3".
+ * Bindings hold for their request only; a variable without one is answered
+ * with "Unknown variable value.", a malformed binding with "Invalid
+ * variable binding.". Variable names are interned for their request only,
+ * so memory stays bounded by the largest request.
+ *
+ * A client gets no more requests read while its responses wait to be sent.
+ * An existing file at socket_path is only replaced if it is a socket.
+ */
+err_t serve(const char *socket_path);
+
+#endif  // !SERVER_H_
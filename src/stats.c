@@ -0,0 +1,112 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stats.h"
+
+#include <string.h>
+#include <time.h>
+
+stats *stats_current = NULL;
+
+static const char *stats_stage_names[] = {"conversion", "evaluation",
+                                          "table", "output"};
+static const char *stats_counter_names[] = {"lines", "rows", "tokens",
+                                            "hash_lookups", "errors"};
+
+uint64_t stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// memory keeps counters at the start of the file until stats_end
+void stats_begin(stats *s) {
+    memory_counters start;
+    size_t i = 0;
+
+    memset(s, 0, sizeof(stats));
+    memory_reset_peaks();
+    for (i = 0; i <= MEM_SUBSYSTEMS_COUNT; ++i) {
+        memory_get_counters((memory_subsystem)i, &start);
+        s->memory[i].allocations = start.allocations;
+        s->memory[i].reallocations = start.reallocations;
+        s->memory[i].frees = start.frees;
+        s->memory[i].bytes = start.bytes;
+        s->memory[i].live_delta_bytes = (int64_t)start.live_bytes;
+    }
+    stats_current = s;
+}
+
+void stats_end(stats *s) {
+    memory_counters now;
+    stats_memory *m = NULL;
+    size_t i = 0, start_live = 0;
+
+    stats_current = NULL;
+    for (i = 0; i <= MEM_SUBSYSTEMS_COUNT; ++i) {
+        memory_get_counters((memory_subsystem)i, &now);
+        m = &s->memory[i];
+        start_live = (size_t)m->live_delta_bytes;
+        m->allocations = now.allocations - m->allocations;
+        m->reallocations = now.reallocations - m->reallocations;
+        m->frees = now.frees - m->frees;
+        m->bytes = now.bytes - m->bytes;
+        m->live_delta_bytes = (int64_t)now.live_bytes - (int64_t)start_live;
+        m->peak_growth_bytes = now.peak_live_bytes > start_live
+                                   ? now.peak_live_bytes - start_live
+                                   : 0;
+    }
+}
+
+void stats_fprint(FILE *out, const char *filename, const stats *s,
+                  output_format format) {
+    const stats_memory *m = NULL;
+    size_t i = 0;
+
+    if (format == format_jsonl) {
+        fputs("{\"file\":\"", out);
+        output_escaped(out, format, filename, strlen(filename));
+        fputs("\",\"stats\":{", out);
+        for (i = 0; i < stats_stages_count; ++i) {
+            fprintf(out, "\"%s_ns\":%llu,", stats_stage_names[i],
+                    (unsigned long long)s->stage_ns[i]);
+        }
+        for (i = 0; i < stats_counters_count; ++i) {
+            fprintf(out, "\"%s\":%llu,", stats_counter_names[i],
+                    (unsigned long long)s->counters[i]);
+        }
+        fputs("\"memory\":{", out);
+        for (i = 0; i <= MEM_SUBSYSTEMS_COUNT; ++i) {
+            m = &s->memory[i];
+            fprintf(out,
+                    "%s\"%s\":{\"allocations\":%zu,\"reallocations\":%zu,"
+                    "\"frees\":%zu,\"bytes\":%zu,\"live_delta_bytes\":%lld,"
+                    "\"peak_growth_bytes\":%zu}",
+                    i == 0 ? "" : ",",
+                    memory_subsystem_name((memory_subsystem)i),
+                    m->allocations, m->reallocations, m->frees, m->bytes,
+                    (long long)m->live_delta_bytes, m->peak_growth_bytes);
+        }
+        fputs("}}}\n", out);
+        return;
+    }
+
+    fprintf(out, "Stats for %s file:\n", filename);
+    for (i = 0; i < stats_stages_count; ++i) {
+        fprintf(out, "    %-12s %12.3f ms\n", stats_stage_names[i],
+                (double)s->stage_ns[i] / 1e6);
+    }
+    for (i = 0; i < stats_counters_count; ++i) {
+        fprintf(out, "    %-12s %12llu\n", stats_counter_names[i],
+                (unsigned long long)s->counters[i]);
+    }
+    fprintf(out, "    %-12s %12s %12s %12s %12s %12s\n", "memory", "allocs",
+            "reallocs", "bytes", "live delta", "peak growth");
+    for (i = 0; i <= MEM_SUBSYSTEMS_COUNT; ++i) {
+        m = &s->memory[i];
+        fprintf(out, "    %-12s %12zu %12zu %12zu %12lld %12zu\n",
+                memory_subsystem_name((memory_subsystem)i), m->allocations,
+                m->reallocations, m->bytes, (long long)m->live_delta_bytes,
+                m->peak_growth_bytes);
+    }
+    fprintf(out, "\n");
+}
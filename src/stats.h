@@ -0,0 +1,72 @@
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../libc/memory.h"
+#include "output.h"
+
+typedef enum {
+    stats_conversion,  // tokenizing and parsing, tree is built on the way
+    stats_evaluation,  // binding variables and evaluating postfix
+    stats_table,       // evaluating and writing truth table
+    stats_output,      // writing everything else
+    stats_stages_count
+} stats_stage;
+
+typedef enum {
+    stats_lines,
+    stats_rows,  // truth table rows
+    stats_tokens,
+    stats_hash_lookups,
+    stats_errors,  // lines skipped because of an error
+    stats_counters_count
+} stats_counter;
+
+// libc allocations made while a file was processed
+typedef struct {
+    size_t allocations;
+    size_t reallocations;
+    size_t frees;
+    size_t bytes;
+    int64_t live_delta_bytes;  // negative if older blocks were freed
+    size_t peak_growth_bytes;  // highest live level above the starting one
+} stats_memory;
+
+typedef struct {
+    uint64_t stage_ns[stats_stages_count];
+    uint64_t counters[stats_counters_count];
+    stats_memory memory[MEM_SUBSYSTEMS_COUNT + 1];  // last one is the total
+} stats;
+
+// stats of the file being processed, NULL unless --stats was passed, so
+// disabled instrumentation costs one predictable branch per span
+extern stats *stats_current;
+
+uint64_t stats_now_ns(void);
+
+// resets s and makes it current
+void stats_begin(stats *s);
+// stops collecting to s and computes its memory counters
+void stats_end(stats *s);
+
+#define stats_span_begin() (stats_current != NULL ? stats_now_ns() : 0)
+#define stats_span_end(stage, begin)                                    \
+    do {                                                                \
+        if (stats_current != NULL) {                                    \
+            stats_current->stage_ns[stage] += stats_now_ns() - (begin); \
+        }                                                               \
+    } while (0)
+#define stats_count(counter, n)                      \
+    do {                                             \
+        if (stats_current != NULL) {                 \
+            stats_current->counters[counter] += (n); \
+        }                                            \
+    } while (0)
+
+// json object for jsonl format, readable block otherwise
+void stats_fprint(FILE *out, const char *filename, const stats *s,
+                  output_format format);
+
+#endif  // !STATS_H_
@@ -7,87 +7,46 @@
 
 #include "../libc/logger.h"
 #include "cli.h"
+#include "error_sink.h"
+#include "output.h"
+#include "parser.h"
 #include "postfix_notation.h"
+#include "stats.h"
 
-void table_u_list_free(void *s) {
-    String *st = s;
-    string_free(*st);
-    free(st);
-    return;
-}
-
-err_t table_validate_postfix(const String postfix_exp, hash_table *operators) {
-    if (postfix_exp == NULL || operators == NULL) {
+err_t table_validate_postfix(const token_list *postfix) {
+    if (postfix == NULL) {
         log_error("passed ptr in NULL");
         return DEREFERENCING_NULL_PTR;
     }
 
-    err_t err = 0;
     size_t i = 0;
-    String token = NULL;
-    char pe = 0, to_validate = 0;
-    operator_t *op = NULL;
+    const token *t = NULL;
+    char to_validate = 0;
 
-    token = string_init();
-    if (token == NULL) {
-        log_error("failed to allocate memory for string");
-        return MEMORY_ALLOCATION_ERROR;
-    }
-
-    for (i = 0; i < string_len(postfix_exp); ++i) {
-        pe = postfix_exp[i];
+    for (i = 0; i < postfix->size; ++i) {
+        t = postfix->tokens + i;
+        if (t->kind != token_number && t->kind != token_variable) {
+            continue;
+        }
 
-        if (pe == ' ') {
-            err = hash_table_get(operators, &token, (void **)&op);
-            if (err != EXIT_SUCCESS && err != KEY_NOT_FOUND) {
-                log_error("failed to get from hash table");
-                string_free(token);
-                return err;
-            }
-            if (err == KEY_NOT_FOUND) {  // is operand
-                // log_debug("%s", token);
-                if (string_len(token) >
-                    1) {  // can be only one-letter vars and '1', '0'
-                    log_error("invalid operator found");
-                    string_free(token);
-                    return INVALID_OPERAND;
-                }
-                to_validate = token[0];
-                if (isdigit(to_validate) && to_validate != '0' &&
-                    to_validate != '1') {
-                    log_error("numeric operator can be only '0' or '1'");
-                    string_free(token);
-                    return INVALID_OPERAND;
-                }
-            }
-            string_free(token);
-            token = NULL;
-            token = string_init();
-            if (token == NULL) {
-                log_error("memory allocation error");
-                return MEMORY_ALLOCATION_ERROR;
-            }
-        } else {
-            err = string_add(&token, pe);
-            if (err) {
-                log_error("string add failed");
-                string_free(token);
-                return err;
-            }
+        if (t->length > 1) {  // can be only one-letter vars and '1', '0'
+            log_error("invalid operator found");
+            return INVALID_OPERAND;
+        }
+        to_validate = postfix->source[t->offset];
+        if (isdigit(to_validate) && to_validate != '0' &&
+            to_validate != '1') {
+            log_error("numeric operator can be only '0' or '1'");
+            return INVALID_OPERAND;
         }
     }
 
-    string_free(token);
-
     return EXIT_SUCCESS;
 }
 
 void table_operators_bucket_free(void *b) {
     hash_table_bucket *bucket = b;
     string_free(*(String *)bucket->key);
-    free(bucket->key);
-    free(bucket->value);
-    free(bucket);
 }
 
 int table_operators_keys_compare(const void *a, const void *b) {
@@ -96,20 +55,6 @@ int table_operators_keys_compare(const void *a, const void *b) {
     return string_cmp(s1, s2);
 }
 
-void table_operands_bucket_free(void *b) {
-    hash_table_bucket *bucket = b;
-    string_free(*(String *)bucket->key);
-    free(bucket->key);
-    free(bucket->value);
-    free(bucket);
-}
-
-int table_operands_keys_compare(const void *a, const void *b) {
-    String s1 = *(String *)a;
-    String s2 = *(String *)b;
-    return string_cmp(s1, s2);
-}
-
 int table_and(int first_arg, ...) {
     va_list args;
     va_start(args, first_arg);
@@ -176,32 +121,6 @@ int table_webber_function(int first_arg, ...) {
     return first_arg ^ second_arg;
 }
 
-int table_priorities(const String operator) {
-    if (string_cmp_c(operator, "&") == 0) {
-        return 0;
-    } else if (string_cmp_c(operator, "|") == 0) {
-        return 1;
-    } else if (string_cmp_c(operator, "~") == 0) {
-        return 2;
-    } else if (string_cmp_c(operator, "->") == 0) {
-        return 3;
-    } else if (string_cmp_c(operator, "+>") == 0) {
-        return 4;
-    } else if (string_cmp_c(operator, "<>") == 0) {
-        return 5;
-    } else if (string_cmp_c(operator, "=") == 0) {
-        return 6;
-    } else if (string_cmp_c(operator, "!") == 0) {
-        return 7;
-    } else if (string_cmp_c(operator, "?") == 0) {
-        return 8;
-    } else if (string_cmp_c(operator, "(") == 0) {
-        return INT_MIN;
-    } else {
-        return -1;
-    }
-}
-
 int table_is_operator(const char *op) {
     const char *valid_operators[] = {"&",  "|", "~", "->", "+>",
                                      "<>", "=", "!", "?"};
@@ -216,13 +135,43 @@ int table_is_operator(const char *op) {
     return 0;
 }
 
-err_t table_infix_to_postfix(const String infix_exp, String *postfix_exp) {
-    return infix_to_postfix(infix_exp, isalnum, table_is_operator,
-                            table_priorities, postfix_exp);
+err_t table_tokenize(const char *line, hash_table *operators,
+                     memory_arena *arena, token_list **tokens) {
+    return tokenize(line, isalnum, table_is_operator, operators, arena,
+                    tokens);
+}
+
+err_t table_init_hash_table(hash_table **operators) {
+    if (operators == NULL) {
+        log_error("passed ptr is NULL");
+        return DEREFERENCING_NULL_PTR;
+    }
+
+    err_t err = 0;
+
+    err = hash_table_init_with_hint(operators, table_operators_keys_compare,
+                                    wyhash_hash, sizeof(String *),
+                                    sizeof(operator_t),
+                                    table_operators_bucket_free,
+                                    TABLE_OPERATORS_COUNT);
+    if (err) {
+        log_error("error while initializing hash table");
+        return err;
+    }
+
+    err = table_fill_hash_table_with_operators(*operators);
+    if (err) {
+        hash_table_free(*operators);
+        *operators = NULL;
+        return err;
+    }
+
+    return EXIT_SUCCESS;
 }
 
-err_t process_table_file(file_to_process *file) {
-    if (file == NULL) {
+err_t process_table_file(file_to_process *file,
+                         const output_options *output) {
+    if (file == NULL || output == NULL) {
         log_error("fin ptr is NULL");
         return DEREFERENCING_NULL_PTR;
     }
@@ -230,32 +179,31 @@ err_t process_table_file(file_to_process *file) {
     char line[BUFSIZ];
     err_t err = 0;
     size_t len = 0, current_line = 0;
-    FILE *fout = NULL;
-    char error_filename[BUFSIZ];
-    hash_table *operators = NULL, *operands = NULL;
-
-    err = hash_table_init(&operators, table_operators_keys_compare, djb2_hash,
-                          sizeof(String *), sizeof(operator_t),
-                          table_operators_bucket_free);
+    error_sink *errors = NULL;
+    error_sink_buffer errors_buffer;
+    const char *error_description = NULL;
+    output_context context = {output, file->filename, 0};
+    int human = output->format == format_human;
+    hash_table *operators = NULL;
+    memory_arena *arena = NULL;  // everything of the current line
+
+    err = table_init_hash_table(&operators);
     if (err) {
-        log_error("error while initializing hash table");
         return err;
     }
-    err = hash_table_init(&operands, table_operands_keys_compare, djb2_hash,
-                          sizeof(String *), sizeof(int),
-                          table_operands_bucket_free);
+    err = memory_arena_init(&arena, MEMORY_ARENA_BLOCK_SIZE);
     if (err) {
-        log_error("error while initializing hash table");
+        log_error("failed to allocate memory for line arena");
         hash_table_free(operators);
         return err;
     }
-
-    err = table_fill_hash_table_with_operators(operators);
+    err = error_sink_init(&errors, file->filename);
     if (err) {
+        memory_arena_free(arena);
         hash_table_free(operators);
-        hash_table_free(operands);
         return err;
     }
+    error_sink_buffer_init(&errors_buffer, errors);
 
     while (fgets(line, sizeof(line), file->data)) {
         len = strlen(line);
@@ -265,153 +213,128 @@ err_t process_table_file(file_to_process *file) {
         if (line[0] == '\0') {
             continue;
         }
-        printf("Processing %zu line in %s file: \n\n", current_line,
-               file->filename);
-        err = process_table_line(line, operators);
-        if (err != EXIT_SUCCESS && err != INVALID_BRACES &&
-            err != INVALID_SYMBOL && err != INVALID_OPERATIONS &&
-            err != INVALID_OPERAND) {
-            if (fout != NULL) {
-                fclose(fout);
-            }
+        context.line = current_line;
+        if (human) {
+            printf("Processing %zu line in %s file: \n\n", current_line,
+                   file->filename);
+        }
+        err = process_table_line(line, operators, stdout, &context, arena);
+        memory_arena_reset(arena);
+        error_description = cli_error_description(err);
+        if (err != EXIT_SUCCESS && error_description == NULL) {
+            error_sink_flush(&errors_buffer);  // keep what was reported
+            error_sink_free(errors);
+            memory_arena_free(arena);
             hash_table_free(operators);
-            hash_table_free(operands);
             return err;
         }
-        if (err == INVALID_BRACES) {
-            if (fout == NULL) {
-                sprintf(error_filename, "%s.errors", file->filename);
-                fout = fopen(error_filename, "w");
-                if (fout == NULL) {
-                    log_error("Error while openning file for errors");
-
-                    hash_table_free(operators);
-                    hash_table_free(operands);
-                    return OPENING_THE_FILE_ERROR;
-                }
-            }
-            fprintf(fout, "%s : %zu : [%s] - Invalid braces placement error.\n",
-                    file->filename, current_line, line);
-            printf("Error occured. Skipping...\n\n");
-            current_line++;
-            continue;
-        } else if (err == INVALID_SYMBOL) {
-            if (fout == NULL) {
-                sprintf(error_filename, "%s.errors", file->filename);
-                fout = fopen(error_filename, "w");
-                if (fout == NULL) {
-                    log_error("Error while openning file for errors");
-                    hash_table_free(operators);
-                    hash_table_free(operands);
-                    return OPENING_THE_FILE_ERROR;
-                }
-            }
-            fprintf(fout, "%s : %zu : [%s] - Invalid symbol occurence error.\n",
-                    file->filename, current_line, line);
-            printf("Error occured. Skipping...\n");
-            current_line++;
-            continue;
-        } else if (err == INVALID_OPERATIONS) {
-            if (fout == NULL) {
-                sprintf(error_filename, "%s.errors", file->filename);
-                fout = fopen(error_filename, "w");
-                if (fout == NULL) {
-                    log_error("Error while openning file for errors");
-                    hash_table_free(operators);
-                    hash_table_free(operands);
-                    return OPENING_THE_FILE_ERROR;
-                }
+        if (error_description != NULL) {
+            stats_count(stats_errors, 1);
+            err = error_sink_report(&errors_buffer, file->filename,
+                                    current_line, line, error_description);
+            if (err) {
+                error_sink_free(errors);
+                memory_arena_free(arena);
+                hash_table_free(operators);
+                return err;
             }
-            fprintf(fout,
-                    "%s : %zu : [%s] - Invalid operations and operands "
-                    "combination.\n",
-                    file->filename, current_line, line);
-            printf("Error occured. Skipping...\n\n");
-            current_line++;
-            continue;
-        } else if (err == INVALID_OPERAND) {
-            if (fout == NULL) {
-                sprintf(error_filename, "%s.errors", file->filename);
-                fout = fopen(error_filename, "w");
-                if (fout == NULL) {
-                    log_error("Error while openning file for errors");
-                    hash_table_free(operators);
-                    hash_table_free(operands);
-                    return OPENING_THE_FILE_ERROR;
-                }
+            if (human) {
+                printf("Error occured. Skipping...\n\n");
+            } else {
+                output_error_record(stdout, &context, error_description);
             }
-            fprintf(fout, "%s : %zu : [%s] - Invalid operand format.\n",
-                    file->filename, current_line, line);
-            printf("Error occured. Skipping...\n\n");
             current_line++;
             continue;
         }
 
-        printf("Ok.\n\n");
+        if (human) {
+            printf("Ok.\n\n");
+        }
         current_line++;
     }
 
-    if (fout != NULL) {
-        fclose(fout);
-    }
+    err = error_sink_flush(&errors_buffer);
+    error_sink_free(errors);
 
+    memory_arena_free(arena);
     hash_table_free(operators);
-    hash_table_free(operands);
 
-    return EXIT_SUCCESS;
+    return err;
 }
 
-err_t process_table_line(char *line, hash_table *operators) {
-    if (line == NULL || operators == NULL) {
+err_t process_table_line(char *line, hash_table *operators, FILE *out,
+                         const output_context *context, memory_arena *arena) {
+    if (line == NULL || operators == NULL || out == NULL || context == NULL) {
         log_error("passed ptr is NULL");
         return DEREFERENCING_NULL_PTR;
     }
 
     err_t err = 0;
-    String infix = NULL, postfix = NULL;
-    int res = 0;
+    token_list *tokens = NULL;
+    unsigned int emit = context->options->emit;
+    output_format format = context->options->format;
+    uint64_t span = 0;
 
-    infix = string_from(line);
-    if (infix == NULL) {
-        log_error("Failed to allocate memory for infix string");
-        return MEMORY_ALLOCATION_ERROR;
-    }
-    postfix = string_init();
-    if (postfix == NULL) {
-        log_error("Failed to allocate memory for postfix string");
-        string_free(infix);
-        return MEMORY_ALLOCATION_ERROR;
-    }
+    stats_count(stats_lines, 1);
 
-    err = table_infix_to_postfix(infix, &postfix);
+    span = stats_span_begin();
+    err = table_tokenize(line, operators, arena, &tokens);
     if (err) {
-        string_free(infix);
-        string_free(postfix);
         return err;
     }
+    stats_count(stats_tokens, tokens->size);
 
-    err = table_validate_postfix(postfix, operators);
+    err = parse_tokens(tokens, NULL);
     if (err) {
-        string_free(infix);
-        string_free(postfix);
+        token_list_free(tokens);
         return err;
     }
 
-    printf("Source: (inf) ");
-    string_print(infix);
-    printf("\nConverted: (post) ");
-    string_print(postfix);
-    printf("\n\n");
-
-    err = table_create_table_of_truth(postfix, operators);
+    err = table_validate_postfix(tokens);
     if (err) {
-        string_free(infix);
-        string_free(postfix);
+        token_list_free(tokens);
         return err;
     }
+    stats_span_end(stats_conversion, span);
+
+    if (format == format_human) {
+        if (emit & EMIT_POSTFIX) {
+            span = stats_span_begin();
+            fprintf(out, "Source: (inf) %s", line);
+            fprintf(out, "\nConverted: (post) ");
+            token_list_fprint(out, tokens);
+            fprintf(out, "\n\n");
+            stats_span_end(stats_output, span);
+        }
+        if (emit & EMIT_TABLE) {
+            span = stats_span_begin();
+            err = table_create_table_of_truth(tokens, out, format, arena);
+            stats_span_end(stats_table, span);
+        }
+        token_list_free(tokens);
+        return err;
+    }
+
+    span = stats_span_begin();
+    output_record_begin(out, context);
+    if (emit & EMIT_POSTFIX) {
+        output_record_field(out, context, "postfix");
+        output_postfix(out, context, tokens);
+    }
+    stats_span_end(stats_output, span);
+    if (emit & EMIT_TABLE) {
+        span = stats_span_begin();
+        output_record_field(out, context, "table");
+        err = table_create_table_of_truth(tokens, out, format, arena);
+        if (err) {
+            token_list_free(tokens);
+            return err;
+        }
+        stats_span_end(stats_table, span);
+    }
+    output_record_end(out, context);
 
-    string_free(infix);
-    string_free(postfix);
+    token_list_free(tokens);
 
     return EXIT_SUCCESS;
 }
@@ -433,6 +356,7 @@ err_t table_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = binary;
+    op->priority = 0;
     representation = string_from("&");
     if (representation == NULL) {
         log_error("Failed to allocate memory for AND operator representation");
@@ -458,6 +382,7 @@ err_t table_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = binary;
+    op->priority = 1;
     representation = string_from("|");
     if (representation == NULL) {
         log_error("Failed to allocate memory for OR operator representation");
@@ -483,6 +408,7 @@ err_t table_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = unary;
+    op->priority = 2;
     representation = string_from("~");
     if (representation == NULL) {
         log_error("Failed to allocate memory for NOT operator representation");
@@ -508,6 +434,7 @@ err_t table_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = binary;
+    op->priority = 3;
     representation = string_from("->");
     if (representation == NULL) {
         log_error(
@@ -535,6 +462,7 @@ err_t table_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = binary;
+    op->priority = 4;
     representation = string_from("+>");
     if (representation == NULL) {
         log_error(
@@ -562,6 +490,7 @@ err_t table_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = binary;
+    op->priority = 5;
     representation = string_from("<>");
     if (representation == NULL) {
         log_error(
@@ -589,6 +518,7 @@ err_t table_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = binary;
+    op->priority = 6;
     representation = string_from("=");
     if (representation == NULL) {
         log_error(
@@ -616,6 +546,7 @@ err_t table_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = binary;
+    op->priority = 7;
     representation = string_from("!");
     if (representation == NULL) {
         log_error(
@@ -643,6 +574,7 @@ err_t table_fill_hash_table_with_operators(hash_table *operators) {
         return MEMORY_ALLOCATION_ERROR;
     }
     op->type = binary;
+    op->priority = 8;
     representation = string_from("?");
     if (representation == NULL) {
         log_error(
@@ -666,180 +598,90 @@ err_t table_fill_hash_table_with_operators(hash_table *operators) {
     return EXIT_SUCCESS;
 }
 
-err_t table_create_table_of_truth(const String postfix_exp,
-                                  hash_table *operators) {
-    if (postfix_exp == NULL || operators == NULL) {
+err_t table_create_table_of_truth(const token_list *postfix, FILE *out,
+                                  output_format format, memory_arena *arena) {
+    if (postfix == NULL || out == NULL) {
         log_error("passed ptr is NULL");
         return DEREFERENCING_NULL_PTR;
     }
 
-    u_list *operands_name = NULL;
     err_t err = 0;
-    size_t i = 0, j = 0, operands_count = 0;
-    u_list_node *current = NULL;
-    String current_name = NULL, for_copy = NULL;
-    int value = 0;
-    hash_table *operands = NULL;
+    size_t i = 0, j = 0, depth = 0, operands_count = postfix->symbols_count;
+    int_vector values, stack;
     int res = 0;
-
-    err = u_list_init(&operands_name, sizeof(String *), table_u_list_free);
+    String name = NULL;
+    // row layout: "<begin>v<separator>v<separator>F<end>"
+    const char *header_begin = "", *header_end = "F\n", *separator = " ";
+    const char *row_begin = "", *row_end = "\n", *table_end = "\n";
+
+    switch (format) {
+        case format_human:
+            break;
+        case format_jsonl:
+            header_begin = "{\"columns\":[";
+            header_end = "\"F\"],\"rows\":[";
+            separator = ",";
+            row_begin = "[";
+            row_end = "]";
+            table_end = "]}";
+            break;
+        case format_tsv:
+            header_end = "F";
+            row_begin = "\\n";
+            row_end = "";
+            table_end = "";
+            break;
+    }
+
+    err = int_vector_init(&values, operands_count + 1, arena);
     if (err) {
-        log_error("failed to create list");
+        log_error("memory allocation error");
         return err;
     }
 
-    err = table_read_variables_to_list(postfix_exp, operators, operands_name);
-    if (err) {
-        u_list_free(operands_name);
-        return err;
-    }
-
-    operands_count = operands_name->size;
-    current = operands_name->first;
-    while (current != NULL) {
-        current_name = *(String *)current->data;
-        printf("%c ", *current_name);
-        current = current->next;
-    }
-    printf("F\n");
-
-    for (i = 0; i < (1 << operands_count); ++i) {
-        j = 0;
-        hash_table_free(operands);
-        err = hash_table_init(&operands, table_operands_keys_compare, djb2_hash,
-                              sizeof(String *), sizeof(int),
-                              table_operands_bucket_free);
-        if (err) {
-            log_error("failed to create hash table");
-            u_list_free(operands_name);
-            return err;
-        }
-        current = operands_name->first;
-        while (current != NULL) {
-            current_name = *(String *)current->data;
-            value = (i & (1 << j)) != 0;
-
-            for_copy = string_init();
-            if (for_copy == NULL) {
-                log_error("memory allocation error");
-                u_list_free(operands_name);
-                hash_table_free(operands);
-                return MEMORY_ALLOCATION_ERROR;
-            }
-
-            err = string_cpy(&for_copy, &current_name);
-            if (err) {
-                log_error("memory allocation error");
-                string_free(for_copy);
-                u_list_free(operands_name);
-                hash_table_free(operands);
-                return err;
-            }
-
-            err = hash_table_set(operands, &for_copy, &value);
-            if (err) {
-                log_error("memory allocation error");
-                string_free(for_copy);
-                u_list_free(operands_name);
-                hash_table_free(operands);
-                return err;
-            }
-            for_copy = NULL;
-            printf("%d ", value);
-            j++;
-            current = current->next;
-        }
-        err = calculate_postfix_expression(postfix_exp, &res, operators,
-                                           operands);
-        if (err) {
-            u_list_free(operands_name);
-            hash_table_free(operands);
-            return err;
+    fputs(header_begin, out);
+    for (j = 0; j < operands_count; ++j) {
+        name = postfix->symbols[j];
+        if (format == format_jsonl) {
+            putc('"', out);
+            output_escaped(out, format, name, string_len(name));
+            putc('"', out);
+        } else {
+            output_escaped(out, format, name, string_len(name));
         }
-        printf("%d\n", res == 0 ? 0 : 1);
+        fputs(separator, out);
     }
+    fputs(header_end, out);
 
-    printf("\n");
-
-    u_list_free(operands_name);
-    hash_table_free(operands);
-    return EXIT_SUCCESS;
-}
-
-err_t table_read_variables_to_list(const String postfix_exp,
-                                   hash_table *operators,
-                                   u_list *operands_name) {
-    if (postfix_exp == NULL || operators == NULL || operands_name == NULL) {
-        log_error("passed ptr is NULL");
-        return DEREFERENCING_NULL_PTR;
+    // rows share one check and one evaluation stack
+    err = postfix_stack_depth(postfix, &depth);
+    if (!err) {
+        err = int_vector_init(&stack, depth, arena);
     }
-
-    err_t err = 0;
-    size_t i = 0;
-    String token = NULL;
-    char pe = 0, to_validate = 0;
-    operator_t *op = NULL;
-    String to_push = NULL;
-
-    token = string_init();
-    if (token == NULL) {
-        log_error("failed to allocate memory for string");
-        return MEMORY_ALLOCATION_ERROR;
+    if (err) {
+        int_vector_free(&values);
+        return err;
     }
 
-    for (i = 0; i < string_len(postfix_exp); ++i) {
-        pe = postfix_exp[i];
-
-        if (pe == ' ') {
-            err = hash_table_get(operators, &token, (void **)&op);
-            if (err != EXIT_SUCCESS && err != KEY_NOT_FOUND) {
-                log_error("failed to get from hash table");
-                string_free(token);
-                return err;
-            }
-            if (err == KEY_NOT_FOUND) {  // is operand
-                if (string_len(token) > 0 && !isdigit(token[0])) {
-                    to_push = string_init();
-                    if (to_push == NULL) {
-                        log_error("failed to allocate memory");
-                        string_free(token);
-                        return MEMORY_ALLOCATION_ERROR;
-                    }
-                    err = string_cpy(&to_push, &token);
-                    if (err) {
-                        log_error("failed to cpy string");
-                        string_free(token);
-                        string_free(to_push);
-                        return err;
-                    }
-                    err = u_list_push_back(operands_name, &to_push);
-                    if (err) {
-                        log_error("failed to push to list");
-                        string_free(token);
-                        string_free(to_push);
-                        return err;
-                    }
-                    to_push = NULL;
-                }
-            }
-            string_free(token);
-            token = NULL;
-            token = string_init();
-            if (token == NULL) {
-                log_error("memory allocation error");
-                return MEMORY_ALLOCATION_ERROR;
-            }
-        } else {
-            err = string_add(&token, pe);
-            if (err) {
-                log_error("string add failed");
-                string_free(token);
-                return err;
-            }
+    for (i = 0; i < ((size_t)1 << operands_count); ++i) {
+        if (format == format_jsonl && i > 0) {
+            putc(',', out);
+        }
+        fputs(row_begin, out);
+        for (j = 0; j < operands_count; ++j) {
+            values.data[j] = (i & ((size_t)1 << j)) != 0;
+            output_int(out, values.data[j]);
+            fputs(separator, out);
         }
+        res = postfix_evaluate(postfix, values.data, &stack);
+        output_int(out, res == 0 ? 0 : 1);
+        fputs(row_end, out);
     }
+    stats_count(stats_rows, (size_t)1 << operands_count);
 
-    string_free(token);
+    fputs(table_end, out);
 
+    int_vector_free(&stack);
+    int_vector_free(&values);
     return EXIT_SUCCESS;
 }
@@ -6,19 +6,30 @@
 #include "../libc/cstring.h"
 #include "../libc/errors.h"
 #include "../libc/hash_table.h"
+#include "../libc/memory.h"
 #include "cli.h"
+#include "lexer.h"
+#include "output.h"
 
-err_t process_table_file(file_to_process *file);
-err_t process_table_line(char *line, hash_table *operators);
+#define TABLE_OPERATORS_COUNT (9)
 
-err_t table_infix_to_postfix(const String infix_exp, String *postfix_exp);
+err_t process_table_file(file_to_process *file, const output_options *output);
+// writes sections of the line selected by context, truth table isn't built
+// unless it's emitted. Everything of the line is allocated from arena, if
+// it's not NULL, and left there for the caller to reset
+err_t process_table_line(char *line, hash_table *operators, FILE *out,
+                         const output_context *context, memory_arena *arena);
+
+err_t table_tokenize(const char *line, hash_table *operators,
+                     memory_arena *arena, token_list **tokens);
+err_t table_validate_postfix(const token_list *postfix);
 
 err_t table_fill_hash_table_with_operators(hash_table *operators);
+err_t table_init_hash_table(hash_table **operators);
 
-err_t table_create_table_of_truth(const String postfix_exp,
-                                  hash_table *operators);
-err_t table_read_variables_to_list(const String postfix_exp,
-                                   hash_table *operators,
-                                   u_list *operands_names);
+// human format prints plain table, jsonl an object with columns and rows
+// and tsv the same plain table as a single escaped field
+err_t table_create_table_of_truth(const token_list *postfix, FILE *out,
+                                  output_format format, memory_arena *arena);
 
 #endif  // !TABLE_H_